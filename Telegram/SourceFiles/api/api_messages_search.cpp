@@ -10,6 +10,7 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include "apiwrap.h"
 #include "data/data_channel.h"
 #include "data/data_histories.h"
+#include "data/data_messages_search_index.h"
 #include "data/data_peer.h"
 #include "data/data_session.h"
 #include "history/history.h"
@@ -78,6 +79,7 @@ void MessagesSearch::searchRequest() {
 			searchReceived(it->second, _requestId, nextToken);
 			return;
 		}
+		searchLocal(nextToken);
 	}
 	auto callback = [=](Fn<void()> finish) {
 		const auto flags = _from
@@ -126,6 +128,21 @@ void MessagesSearch::searchRequest() {
 		std::move(callback));
 }
 
+void MessagesSearch::searchLocal(const QString &nextToken) {
+	if (_history->migrateSibling()) {
+		// Merging with the migrated history results relies on the totals.
+		return;
+	}
+	if (!_searchIndex) {
+		_searchIndex = _history->searchIndex();
+	}
+	auto found = _searchIndex->search(_query, _from);
+	if (!found.empty()) {
+		const auto total = int(found.size());
+		_messagesFounds.fire({ total, std::move(found), nextToken, true });
+	}
+}
+
 void MessagesSearch::searchReceived(
 		const TLMessages &result,
 		mtpRequestId requestId,
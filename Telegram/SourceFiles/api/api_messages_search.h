@@ -11,12 +11,19 @@ class HistoryItem;
 class History;
 class PeerData;
 
+namespace Data {
+class MessagesSearchIndex;
+} // namespace Data
+
 namespace Api {
 
 struct FoundMessages {
 	int total = -1;
 	MessageIdsList messages;
 	QString nextToken;
+
+	// Found in the loaded messages, merged with the server results.
+	bool local = false;
 };
 
 class MessagesSearch final {
@@ -32,12 +39,14 @@ public:
 private:
 	using TLMessages = MTPmessages_Messages;
 	void searchRequest();
+	void searchLocal(const QString &nextToken);
 	void searchReceived(
 		const TLMessages &result,
 		mtpRequestId requestId,
 		const QString &nextToken);
 
 	const not_null<History*> _history;
+	std::shared_ptr<Data::MessagesSearchIndex> _searchIndex;
 
 	base::flat_map<QString, TLMessages> _cacheOfStartByToken;
 
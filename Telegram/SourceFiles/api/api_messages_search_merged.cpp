@@ -43,12 +43,23 @@ MessagesSearchMerged::MessagesSearchMerged(not_null<History*> history)
 
 	_apiSearch.messagesFounds(
 	) | rpl::start_with_next([=](const FoundMessages &data) {
-		if (data.nextToken == _concatedFound.nextToken) {
+		if (data.local) {
+			// Local results are not full, the server total is unknown yet.
+			_concatedFound = data;
+			_localFound.clear();
+			checkWaitingForTotal();
+		} else if (data.nextToken == _concatedFound.nextToken
+			&& _concatedFound.local) {
+			mergeLocalFound(data);
+			checkFull(data);
+			checkWaitingForTotal();
+		} else if (data.nextToken == _concatedFound.nextToken) {
 			addFound(data);
 			checkFull(data);
 			_nextFounds.fire({});
 		} else {
 			_concatedFound = data;
+			_localFound.clear();
 			checkFull(data);
 			checkWaitingForTotal();
 		}
@@ -71,9 +82,38 @@ MessagesSearchMerged::MessagesSearchMerged(not_null<History*> history)
 }
 
 void MessagesSearchMerged::addFound(const FoundMessages &data) {
+	auto &messages = _concatedFound.messages;
+	if (_localFound.empty()) {
+		for (const auto &message : data.messages) {
+			messages.push_back(message);
+		}
+		return;
+	}
+
+	// Skip the local results that the server returned only now
+	// and keep the list ordered from the newest message.
 	for (const auto &message : data.messages) {
-		_concatedFound.messages.push_back(message);
+		if (!_localFound.remove(message)) {
+			messages.push_back(message);
+		}
+	}
+	ranges::sort(messages, ranges::greater(), &FullMsgId::msg);
+}
+
+void MessagesSearchMerged::mergeLocalFound(const FoundMessages &data) {
+	// Keep the local results that are not in the first server page yet,
+	// they're skipped when the following pages bring them.
+	auto &messages = _concatedFound.messages;
+	_localFound = base::flat_set<FullMsgId>(begin(messages), end(messages));
+	messages = data.messages;
+	for (const auto &message : messages) {
+		_localFound.remove(message);
 	}
+	messages.insert(end(messages), begin(_localFound), end(_localFound));
+	ranges::sort(messages, ranges::greater(), &FullMsgId::msg);
+
+	_concatedFound.total = std::max(data.total, int(messages.size()));
+	_concatedFound.local = false;
 }
 
 const FoundMessages &MessagesSearchMerged::messages() const {
@@ -83,6 +123,8 @@ const FoundMessages &MessagesSearchMerged::messages() const {
 void MessagesSearchMerged::clear() {
 	_concatedFound = {};
 	_migratedFirstFound = {};
+	_localFound.clear();
+	_isFull = false;
 }
 
 void MessagesSearchMerged::search(const Request &search) {
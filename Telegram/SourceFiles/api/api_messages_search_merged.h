@@ -39,6 +39,7 @@ public:
 
 private:
 	void addFound(const FoundMessages &data);
+	void mergeLocalFound(const FoundMessages &data);
 
 	MessagesSearch _apiSearch;
 
@@ -47,6 +48,9 @@ private:
 
 	FoundMessages _concatedFound;
 
+	// Local results not returned by the server yet.
+	base::flat_set<FullMsgId> _localFound;
+
 	bool _waitingForTotal = false;
 	bool _isFull = false;
 
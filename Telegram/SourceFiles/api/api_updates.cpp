@@ -97,6 +97,23 @@ void ProcessScheduledMessageWithElapsedTime(
 	}
 }
 
+void LogDifferenceApplied(
+		not_null<Main::Session*> session,
+		int messages,
+		int updates,
+		crl::time started) {
+	if (Logs::DebugEnabled() && (messages || updates)) {
+		DEBUG_LOG(("Api Info: difference applied, "
+			"%1 messages, %2 updates in %3 ms (%4)."
+			).arg(messages
+			).arg(updates
+			).arg(crl::now() - started
+			).arg(session->data().chatListRefreshesBatched()
+				? "batched"
+				: "unbatched"));
+	}
+}
+
 bool IsForceLogoutNotification(const MTPDupdateServiceNotification &data) {
 	return qs(data.vtype()).startsWith(u"AUTH_KEY_DROP_"_q);
 }
@@ -425,18 +442,27 @@ void Updates::channelDifferenceDone(
 
 void Updates::feedChannelDifference(
 		const MTPDupdates_channelDifference &data) {
-	session().data().processUsers(data.vusers());
-	session().data().processChats(data.vchats());
+	const auto started = crl::now();
+	auto &owner = session().data();
+	owner.processUsers(data.vusers());
+	owner.processChats(data.vchats());
 
 	_handlingChannelDifference = true;
-	feedMessageIds(data.vother_updates());
-	session().data().processMessages(
-		data.vnew_messages(),
-		NewMessageType::Unread);
-	feedUpdateVector(
-		data.vother_updates(),
-		SkipUpdatePolicy::SkipMessageIds);
+	{
+		const auto hold = owner.holdChatListRefreshes();
+		feedMessageIds(data.vother_updates());
+		owner.processMessages(data.vnew_messages(), NewMessageType::Unread);
+		feedUpdateVector(
+			data.vother_updates(),
+			SkipUpdatePolicy::SkipMessageIds);
+	}
 	_handlingChannelDifference = false;
+
+	LogDifferenceApplied(
+		&session(),
+		data.vnew_messages().v.size(),
+		data.vother_updates().v.size(),
+		started);
 }
 
 void Updates::channelDifferenceFail(
@@ -591,11 +617,20 @@ void Updates::feedDifference(
 		const MTPVector<MTPMessage> &msgs,
 		const MTPVector<MTPUpdate> &other) {
 	Core::App().checkAutoLock();
-	session().data().processUsers(users);
-	session().data().processChats(chats);
-	feedMessageIds(other);
-	session().data().processMessages(msgs, NewMessageType::Unread);
-	feedUpdateVector(other, SkipUpdatePolicy::SkipMessageIds);
+	const auto started = crl::now();
+	auto &owner = session().data();
+	owner.processUsers(users);
+	owner.processChats(chats);
+
+	// Reorder each affected chat once per slice instead of once per message.
+	{
+		const auto hold = owner.holdChatListRefreshes();
+		feedMessageIds(other);
+		owner.processMessages(msgs, NewMessageType::Unread);
+		feedUpdateVector(other, SkipUpdatePolicy::SkipMessageIds);
+	}
+
+	LogDifferenceApplied(&session(), msgs.v.size(), other.v.size(), started);
 }
 
 void Updates::differenceFail(const MTP::Error &error) {
@@ -38,12 +38,53 @@ struct LangPackEmoji {
 	QString text;
 };
 
+using LangPackMap = std::map<QString, std::vector<LangPackEmoji>>;
+
+// Immutable between updates, so kept in flat arrays instead of a map:
+// keys are sorted and emoji of keys[i] are emoji[offsets[i]] up to
+// emoji[offsets[i + 1]], which makes a prefix a range of keys.
 struct LangPackData {
 	int version = 0;
 	int maxKeyLength = 0;
-	std::map<QString, std::vector<LangPackEmoji>> emoji;
+	std::vector<QString> keys;
+	std::vector<int> offsets;
+	std::vector<LangPackEmoji> emoji;
 };
 
+[[nodiscard]] LangPackData PackLangData(int version, LangPackMap &&map) {
+	auto result = LangPackData{ .version = version };
+	auto count = 0;
+	for (const auto &[key, list] : map) {
+		count += int(list.size());
+	}
+	result.keys.reserve(map.size());
+	result.offsets.reserve(map.size() + 1);
+	result.emoji.reserve(count);
+	for (auto &[key, list] : map) {
+		result.maxKeyLength = std::max(result.maxKeyLength, int(key.size()));
+		result.keys.push_back(key);
+		result.offsets.push_back(int(result.emoji.size()));
+		result.emoji.insert(
+			end(result.emoji),
+			std::make_move_iterator(begin(list)),
+			std::make_move_iterator(end(list)));
+	}
+	result.offsets.push_back(int(result.emoji.size()));
+	return result;
+}
+
+[[nodiscard]] LangPackMap UnpackLangData(const LangPackData &data) {
+	auto result = LangPackMap();
+	for (auto i = 0, count = int(data.keys.size()); i != count; ++i) {
+		result.emplace(
+			data.keys[i],
+			std::vector<LangPackEmoji>(
+				begin(data.emoji) + data.offsets[i],
+				begin(data.emoji) + data.offsets[i + 1]));
+	}
+	return result;
+}
+
 [[nodiscard]] bool MustAddPostfix(const QString &text) {
 	if (text.size() != 1) {
 		return false;
@@ -99,7 +140,7 @@ void CreateCacheFilePath() {
 	if (!file.open(QIODevice::ReadOnly)) {
 		return {};
 	}
-	auto result = LangPackData();
+	auto result = LangPackMap();
 	auto stream = QDataStream(&file);
 	stream.setVersion(QDataStream::Qt_5_1);
 	auto version = qint32();
@@ -119,7 +160,7 @@ void CreateCacheFilePath() {
 		if (size < 0 || stream.status() != QDataStream::Ok) {
 			return {};
 		}
-		auto &list = result.emoji[key];
+		auto &list = result[key];
 		for (auto j = 0; j != size; ++j) {
 			auto text = QString();
 			stream >> text;
@@ -135,14 +176,12 @@ void CreateCacheFilePath() {
 			}
 			list.push_back(entry);
 		}
-		result.maxKeyLength = std::max(result.maxKeyLength, int(key.size()));
 	}
-	result.version = version;
-	return result;
+	return PackLangData(version, std::move(result));
 }
 
 void WriteLocalCache(const QString &id, const LangPackData &data) {
-	if (!data.version && data.emoji.empty()) {
+	if (!data.version && data.keys.empty()) {
 		return;
 	}
 	CreateCacheFilePath();
@@ -154,13 +193,15 @@ void WriteLocalCache(const QString &id, const LangPackData &data) {
 	stream.setVersion(QDataStream::Qt_5_1);
 	stream
 		<< qint32(data.version)
-		<< qint32(data.emoji.size());
-	for (const auto &[key, list] : data.emoji) {
+		<< qint32(data.keys.size());
+	for (auto i = 0, count = int(data.keys.size()); i != count; ++i) {
+		const auto from = data.offsets[i];
+		const auto till = data.offsets[i + 1];
 		stream
-			<< key
-			<< qint32(list.size());
-		for (const auto &emoji : list) {
-			stream << emoji.text;
+			<< data.keys[i]
+			<< qint32(till - from);
+		for (auto j = from; j != till; ++j) {
+			stream << data.emoji[j].text;
 		}
 	}
 }
@@ -175,26 +216,14 @@ void WriteLocalCache(const QString &id, const LangPackData &data) {
 
 void AppendFoundEmoji(
 		std::vector<Result> &result,
+		std::unordered_set<EmojiPtr> &found,
 		const QString &label,
-		const std::vector<LangPackEmoji> &list) {
-	// It is important that the 'result' won't relocate while inserting.
-	result.reserve(result.size() + list.size());
-	const auto alreadyBegin = begin(result);
-	const auto alreadyEnd = alreadyBegin + result.size();
-
-	auto &&add = ranges::views::all(
-		list
-	) | ranges::views::filter([&](const LangPackEmoji &entry) {
-		const auto i = ranges::find(
-			alreadyBegin,
-			alreadyEnd,
-			entry.emoji,
-			&Result::emoji);
-		return (i == alreadyEnd);
-	}) | ranges::views::transform([&](const LangPackEmoji &entry) {
-		return Result{ entry.emoji, label, entry.text };
-	});
-	result.insert(end(result), add.begin(), add.end());
+		gsl::span<const LangPackEmoji> list) {
+	for (const auto &entry : list) {
+		if (found.emplace(entry.emoji).second) {
+			result.push_back({ entry.emoji, label, entry.text });
+		}
+	}
 }
 
 void AppendLegacySuggestions(
@@ -245,14 +274,14 @@ void ApplyDifference(
 		LangPackData &data,
 		const QVector<MTPEmojiKeyword> &keywords,
 		int version) {
-	data.version = version;
+	auto map = UnpackLangData(data);
 	for (const auto &keyword : keywords) {
 		keyword.match([&](const MTPDemojiKeyword &keyword) {
 			const auto word = NormalizeKey(qs(keyword.vkeyword()));
 			if (word.isEmpty()) {
 				return;
 			}
-			auto &list = data.emoji[word];
+			auto &list = map[word];
 			auto &&emoji = ranges::views::all(
 				keyword.vemoticons().v
 			) | ranges::views::transform([](const MTPstring &string) {
@@ -276,8 +305,8 @@ void ApplyDifference(
 			if (word.isEmpty()) {
 				return;
 			}
-			const auto i = data.emoji.find(word);
-			if (i == end(data.emoji)) {
+			const auto i = map.find(word);
+			if (i == end(map)) {
 				return;
 			}
 			auto &list = i->second;
@@ -287,20 +316,11 @@ void ApplyDifference(
 					end(list));
 			}
 			if (list.empty()) {
-				data.emoji.erase(i);
+				map.erase(i);
 			}
 		});
 	}
-	if (data.emoji.empty()) {
-		data.maxKeyLength = 0;
-	} else {
-		auto &&lengths = ranges::views::all(
-			data.emoji
-		) | ranges::views::transform([](auto &&pair) {
-			return pair.first.size();
-		});
-		data.maxKeyLength = *ranges::max_element(lengths);
-	}
+	data = PackLangData(version, std::move(map));
 }
 
 } // namespace
@@ -474,23 +494,25 @@ std::vector<Result> EmojiKeywords::LangPack::query(
 		const QString &normalized,
 		bool exact) const {
 	if (normalized.size() > _data.maxKeyLength
-		|| _data.emoji.empty()
+		|| _data.keys.empty()
 		|| (exact && SkipExactKeyword(_id, normalized))) {
 		return {};
 	}
 
-	const auto from = _data.emoji.lower_bound(normalized);
-	auto &&chosen = ranges::make_subrange(
-		from,
-		end(_data.emoji)
-	) | ranges::views::take_while([&](const auto &pair) {
-		const auto &key = pair.first;
+	const auto &keys = _data.keys;
+	const auto from = ranges::lower_bound(keys, normalized);
+	const auto till = std::partition_point(from, end(keys), [&](
+			const QString &key) {
 		return exact ? (key == normalized) : key.startsWith(normalized);
 	});
 
 	auto result = std::vector<Result>();
-	for (const auto &[key, list] : chosen) {
-		AppendFoundEmoji(result, key, list);
+	auto found = std::unordered_set<EmojiPtr>();
+	const auto emoji = _data.emoji.data();
+	for (auto i = int(from - begin(keys)); i != int(till - begin(keys)); ++i) {
+		AppendFoundEmoji(result, found, keys[i], gsl::make_span(
+			emoji + _data.offsets[i],
+			emoji + _data.offsets[i + 1]));
 	}
 	return result;
 }
@@ -613,27 +635,23 @@ std::vector<Result> EmojiKeywords::query(
 		return {};
 	}
 	auto result = std::vector<Result>();
+	auto found = std::unordered_set<EmojiPtr>();
 	for (const auto &[language, item] : _data) {
-		const auto list = item->query(normalized, exact);
-
-		// It is important that the 'result' won't relocate while inserting.
-		result.reserve(result.size() + list.size());
-		const auto alreadyBegin = begin(result);
-		const auto alreadyEnd = alreadyBegin + result.size();
-
-		auto &&add = ranges::views::all(
-			list
-		) | ranges::views::filter([&](Result entry) {
+		auto list = item->query(normalized, exact);
+		if (result.empty()) {
 			// In each item->query() result the list has no duplicates.
 			// So we need to check only for duplicates between queries.
-			const auto i = ranges::find(
-				alreadyBegin,
-				alreadyEnd,
-				entry.emoji,
-				&Result::emoji);
-			return (i == alreadyEnd);
-		});
-		result.insert(end(result), add.begin(), add.end());
+			result = std::move(list);
+			for (const auto &entry : result) {
+				found.emplace(entry.emoji);
+			}
+			continue;
+		}
+		for (auto &entry : list) {
+			if (found.emplace(entry.emoji).second) {
+				result.push_back(std::move(entry));
+			}
+		}
 	}
 	if (!exact) {
 		AppendLegacySuggestions(result, query);
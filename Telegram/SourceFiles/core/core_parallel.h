@@ -0,0 +1,59 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop application for the Telegram messaging service.
+
+For license and copyright information please follow this link:
+https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
+*/
+#pragma once
+
+#include <crl/crl_async.h>
+#include <crl/crl_semaphore.h>
+#include <QtCore/QThread>
+
+#include <atomic>
+
+namespace Core {
+
+// Calls method(index) for each index in [0, count) and returns when all
+// of them are done. Indices are taken from a shared counter by crl
+// workers and by the calling thread, so if all the workers are busy
+// the calling thread processes everything itself instead of waiting.
+template <typename Method>
+void InvokeParallel(int count, Method &&method) {
+	if (count < 2) {
+		for (auto i = 0; i < count; ++i) {
+			method(i);
+		}
+		return;
+	}
+	struct State {
+		std::atomic<int> next = 0;
+		std::atomic<int> done = 0;
+		crl::semaphore finished;
+	};
+	const auto state = std::make_shared<State>();
+
+	// The method is used only while some index is not done yet,
+	// so capturing it by reference is safe even for late workers.
+	const auto work = [=, &method] {
+		while (true) {
+			const auto index = state->next++;
+			if (index >= count) {
+				return;
+			}
+			method(index);
+			if (++state->done == count) {
+				state->finished.release();
+			}
+		}
+	};
+	const auto workers = std::min(count, QThread::idealThreadCount()) - 1;
+	for (auto i = 0; i < workers; ++i) {
+		crl::async(work);
+	}
+	work();
+	state->finished.acquire();
+}
+
+} // namespace Core
@@ -10,6 +10,12 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include "main/main_session.h"
 
 namespace Data {
+namespace {
+
+// Log merge statistics once this many merges were accumulated.
+constexpr auto kLogMergedCount = 1000;
+
+} // namespace
 
 template <typename DataType, typename UpdateType>
 void Changes::Manager<DataType, UpdateType>::updated(
@@ -25,10 +31,41 @@ void Changes::Manager<DataType, UpdateType>::updated(
 		}
 		_stream.fire({ data, flags });
 	} else {
-		_updates[data] |= flags;
+		auto &scheduled = _updates[data];
+		countMerged(scheduled & flags);
+		scheduled |= flags;
+	}
+}
+
+template <typename DataType, typename UpdateType>
+void Changes::Manager<DataType, UpdateType>::countMerged(Flags flags) {
+	if (!flags || !Logs::DebugEnabled()) {
+		return;
+	}
+	for (auto i = 0; i != kCount; ++i) {
+		if (flags & static_cast<Flag>(1ULL << i)) {
+			++_merged[i];
+			++_mergedCount;
+		}
 	}
 }
 
+template <typename DataType, typename UpdateType>
+QString Changes::Manager<DataType, UpdateType>::takeMergedStats() {
+	const auto result = u"%1 sent, %2 merged"_q
+		.arg(base::take(_sentCount))
+		.arg(base::take(_mergedCount));
+	auto bits = QStringList();
+	for (auto i = 0; i != kCount; ++i) {
+		if (const auto merged = base::take(_merged[i])) {
+			bits.push_back(u"bit%1: %2"_q.arg(i).arg(merged));
+		}
+	}
+	return bits.isEmpty()
+		? result
+		: (result + u" ("_q + bits.join(u", "_q) + ')');
+}
+
 template <typename DataType, typename UpdateType>
 void Changes::Manager<DataType, UpdateType>::sendRealtimeNotifications(
 		not_null<DataType*> data,
@@ -83,7 +120,11 @@ void Changes::Manager<DataType, UpdateType>::drop(not_null<DataType*> data) {
 
 template <typename DataType, typename UpdateType>
 void Changes::Manager<DataType, UpdateType>::sendNotifications() {
-	for (const auto &[data, flags] : base::take(_updates)) {
+	const auto updates = base::take(_updates);
+	if (Logs::DebugEnabled()) {
+		_sentCount += int(updates.size());
+	}
+	for (const auto &[data, flags] : updates) {
 		_stream.fire({ data, flags });
 	}
 }
@@ -324,6 +365,31 @@ void Changes::sendNotifications() {
 	_entryChanges.sendNotifications();
 	_topicChanges.sendNotifications();
 	_storyChanges.sendNotifications();
+
+	if (Logs::DebugEnabled()) {
+		logMergedNotifications();
+	}
+}
+
+void Changes::logMergedNotifications() {
+	const auto merged = _peerChanges.mergedCount()
+		+ _historyChanges.mergedCount()
+		+ _messageChanges.mergedCount()
+		+ _entryChanges.mergedCount()
+		+ _topicChanges.mergedCount()
+		+ _storyChanges.mergedCount();
+	if (merged < kLogMergedCount) {
+		return;
+	}
+	DEBUG_LOG(("Data Info: notifications merged, "
+		"peer: %1; history: %2; message: %3; "
+		"entry: %4; topic: %5; story: %6."
+		).arg(_peerChanges.takeMergedStats()
+		).arg(_historyChanges.takeMergedStats()
+		).arg(_messageChanges.takeMergedStats()
+		).arg(_entryChanges.takeMergedStats()
+		).arg(_topicChanges.takeMergedStats()
+		).arg(_storyChanges.takeMergedStats()));
 }
 
 } // namespace Data
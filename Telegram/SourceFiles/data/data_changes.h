@@ -364,20 +364,32 @@ private:
 
 		void sendNotifications();
 
+		// Flags that were merged into already scheduled updates.
+		[[nodiscard]] int mergedCount() const {
+			return _mergedCount;
+		}
+		[[nodiscard]] QString takeMergedStats();
+
 	private:
 		static constexpr auto kCount = details::CountBit<Flag>() + 1;
 
 		void sendRealtimeNotifications(
 			not_null<DataType*> data,
 			Flags flags);
+		void countMerged(Flags flags);
 
 		std::array<rpl::event_stream<UpdateType>, kCount> _realtimeStreams;
 		base::flat_map<not_null<DataType*>, Flags> _updates;
 		rpl::event_stream<UpdateType> _stream;
 
+		std::array<int, kCount> _merged = { { 0 } };
+		int _mergedCount = 0;
+		int _sentCount = 0;
+
 	};
 
 	void scheduleNotifications();
+	void logMergedNotifications();
 
 	const not_null<Main::Session*> _session;
 
@@ -0,0 +1,110 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop application for the Telegram messaging service.
+
+For license and copyright information please follow this link:
+https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
+*/
+#include "data/data_messages_registry.h"
+
+namespace Data {
+namespace {
+
+constexpr auto kMinCapacity = 64;
+
+[[nodiscard]] uint64 Hash(FullMsgId id) {
+	// Message ids in one chat are sequential, mix all the bits,
+	// because only the lowest ones are used for the slot index.
+	auto result = uint64(id.peer.value) * 0x9E3779B97F4A7C15ULL
+		+ uint64(id.msg.bare);
+	result = (result ^ (result >> 30)) * 0xBF58476D1CE4E5B9ULL;
+	result = (result ^ (result >> 27)) * 0x94D049BB133111EBULL;
+	return result ^ (result >> 31);
+}
+
+} // namespace
+
+HistoryItem *MessagesRegistry::find(FullMsgId id) const {
+	return _entries.empty() ? nullptr : _entries[indexOf(id)].item;
+}
+
+void MessagesRegistry::set(FullMsgId id, not_null<HistoryItem*> item) {
+	// Keep the load factor under 3/4, so there always are empty entries.
+	const auto capacity = int(_entries.size());
+	if ((_size + 1) * 4 > capacity * 3) {
+		rehash(capacity ? (capacity * 2) : kMinCapacity);
+	}
+	auto &entry = _entries[indexOf(id)];
+	if (!entry.item) {
+		entry.id = id;
+		++_size;
+	}
+	entry.item = item;
+}
+
+void MessagesRegistry::remove(FullMsgId id) {
+	if (_entries.empty()) {
+		return;
+	}
+	auto index = indexOf(id);
+	if (!_entries[index].item) {
+		return;
+	}
+	const auto mask = int(_entries.size()) - 1;
+
+	// Backward shift deletion: move the following entries of the cluster
+	// into the hole if their ideal position is not after the hole.
+	for (auto next = (index + 1) & mask
+		; _entries[next].item
+		; next = (next + 1) & mask) {
+		const auto ideal = int(Hash(_entries[next].id) & mask);
+		if (((next - ideal) & mask) >= ((next - index) & mask)) {
+			_entries[index] = _entries[next];
+			index = next;
+		}
+	}
+	_entries[index] = Entry();
+	--_size;
+
+	const auto capacity = int(_entries.size());
+	if (capacity > kMinCapacity && _size * 8 < capacity) {
+		rehash(capacity / 2);
+	}
+}
+
+void MessagesRegistry::clear() {
+	_entries = std::vector<Entry>();
+	_size = 0;
+}
+
+int MessagesRegistry::size() const {
+	return _size;
+}
+
+bool MessagesRegistry::empty() const {
+	return !_size;
+}
+
+int MessagesRegistry::indexOf(FullMsgId id) const {
+	Expects(!_entries.empty());
+
+	const auto mask = int(_entries.size()) - 1;
+	auto index = int(Hash(id) & mask);
+	while (_entries[index].item && _entries[index].id != id) {
+		index = (index + 1) & mask;
+	}
+	return index;
+}
+
+void MessagesRegistry::rehash(int capacity) {
+	Expects(capacity > 0 && !(capacity & (capacity - 1)));
+
+	auto was = std::exchange(_entries, std::vector<Entry>(capacity));
+	for (const auto &entry : was) {
+		if (entry.item) {
+			_entries[indexOf(entry.id)] = entry;
+		}
+	}
+}
+
+} // namespace Data
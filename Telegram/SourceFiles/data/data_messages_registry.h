@@ -0,0 +1,40 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop application for the Telegram messaging service.
+
+For license and copyright information please follow this link:
+https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
+*/
+#pragma once
+
+class HistoryItem;
+
+namespace Data {
+
+// Open addressing hash table of messages by their full ids, all of the
+// entries are kept in a single array for cache friendly lookups.
+class MessagesRegistry final {
+public:
+	[[nodiscard]] HistoryItem *find(FullMsgId id) const;
+	void set(FullMsgId id, not_null<HistoryItem*> item);
+	void remove(FullMsgId id);
+	void clear();
+
+	[[nodiscard]] int size() const;
+	[[nodiscard]] bool empty() const;
+
+private:
+	struct Entry {
+		FullMsgId id;
+		HistoryItem *item = nullptr;
+	};
+
+	[[nodiscard]] int indexOf(FullMsgId id) const;
+	void rehash(int capacity);
+
+	std::vector<Entry> _entries;
+	int _size = 0;
+
+};
+
+} // namespace Data
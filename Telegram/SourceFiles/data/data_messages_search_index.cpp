@@ -0,0 +1,156 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop application for the Telegram messaging service.
+
+For license and copyright information please follow this link:
+https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
+*/
+#include "data/data_messages_search_index.h"
+
+#include "history/history_item.h"
+
+namespace Data {
+namespace {
+
+[[nodiscard]] QStringList ItemWords(not_null<HistoryItem*> item) {
+	if (!item->isRegular()) {
+		return {};
+	}
+	auto result = TextUtilities::PrepareSearchWords(
+		item->originalText().text);
+	result.removeDuplicates();
+	return result;
+}
+
+} // namespace
+
+MessagesSearchIndex::MessagesSearchIndex(
+		const std::vector<not_null<HistoryItem*>> &items) {
+	const auto started = crl::now();
+	for (const auto &item : items) {
+		update(item);
+	}
+	_updates = 0;
+	_updatesDuration = 0;
+	DEBUG_LOG(("Search Index Info: built for %1 messages in %2ms, "
+		"%3 words, about %4 KB."
+		).arg(items.size()
+		).arg(crl::now() - started
+		).arg(_itemsByWord.size()
+		).arg(countMemoryUsage() / 1024));
+}
+
+MessagesSearchIndex::~MessagesSearchIndex() {
+	DEBUG_LOG(("Search Index Info: %1 updates in %2ms, "
+		"%3 words, about %4 KB."
+		).arg(_updates
+		).arg(_updatesDuration
+		).arg(_itemsByWord.size()
+		).arg(countMemoryUsage() / 1024));
+}
+
+void MessagesSearchIndex::update(not_null<HistoryItem*> item) {
+	const auto started = crl::now();
+	remove(item);
+	auto words = ItemWords(item);
+	if (!words.isEmpty()) {
+		for (const auto &word : words) {
+			_itemsByWord[word].emplace(item);
+		}
+		_wordsByItem.emplace(item, std::move(words));
+	}
+	++_updates;
+	_updatesDuration += crl::now() - started;
+}
+
+void MessagesSearchIndex::remove(not_null<HistoryItem*> item) {
+	const auto i = _wordsByItem.find(item);
+	if (i == end(_wordsByItem)) {
+		return;
+	}
+	for (const auto &word : i->second) {
+		const auto j = _itemsByWord.find(word);
+		if (j != end(_itemsByWord)) {
+			j->second.remove(item);
+			if (j->second.empty()) {
+				_itemsByWord.erase(j);
+			}
+		}
+	}
+	_wordsByItem.erase(i);
+}
+
+auto MessagesSearchIndex::findByPrefix(const QString &prefix) const
+-> Items {
+	auto result = Items();
+	for (auto i = _itemsByWord.lower_bound(prefix)
+		; i != end(_itemsByWord) && i->first.startsWith(prefix)
+		; ++i) {
+		if (result.empty()) {
+			result = i->second;
+		} else {
+			for (const auto &item : i->second) {
+				result.emplace(item);
+			}
+		}
+	}
+	return result;
+}
+
+MessageIdsList MessagesSearchIndex::search(
+		const QString &query,
+		PeerData *from) const {
+	const auto words = TextUtilities::PrepareSearchWords(query);
+	if (words.isEmpty()) {
+		return {};
+	}
+	auto found = std::optional<Items>();
+	for (const auto &word : words) {
+		auto items = findByPrefix(word);
+		if (found) {
+			for (auto i = begin(*found); i != end(*found);) {
+				if (items.contains(*i)) {
+					++i;
+				} else {
+					i = found->erase(i);
+				}
+			}
+		} else {
+			found = std::move(items);
+		}
+		if (found->empty()) {
+			return {};
+		}
+	}
+	auto items = std::vector<not_null<HistoryItem*>>();
+	items.reserve(found->size());
+	for (const auto &item : *found) {
+		if (!from || item->from() == from) {
+			items.push_back(item);
+		}
+	}
+	ranges::sort(items, ranges::greater(), &HistoryItem::id);
+
+	auto result = MessageIdsList();
+	result.reserve(items.size());
+	for (const auto &item : items) {
+		result.push_back(item->fullId());
+	}
+	return result;
+}
+
+int64 MessagesSearchIndex::countMemoryUsage() const {
+	constexpr auto kNodeSize = int64(sizeof(void*) * 4);
+	constexpr auto kItemSize = int64(sizeof(void*));
+	auto result = int64(0);
+	for (const auto &[word, items] : _itemsByWord) {
+		result += kNodeSize + word.size() * sizeof(QChar);
+		result += int64(items.size()) * kItemSize;
+	}
+	for (const auto &[item, words] : _wordsByItem) {
+		result += kNodeSize + int64(words.size()) * kItemSize;
+	}
+	return result;
+}
+
+} // namespace Data
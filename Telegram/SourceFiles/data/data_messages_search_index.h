@@ -0,0 +1,45 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop application for the Telegram messaging service.
+
+For license and copyright information please follow this link:
+https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
+*/
+#pragma once
+
+class HistoryItem;
+class PeerData;
+
+namespace Data {
+
+// Word index of the text of messages loaded in one history.
+class MessagesSearchIndex final {
+public:
+	explicit MessagesSearchIndex(
+		const std::vector<not_null<HistoryItem*>> &items);
+	~MessagesSearchIndex();
+
+	void update(not_null<HistoryItem*> item);
+	void remove(not_null<HistoryItem*> item);
+
+	// Server messages having words starting with each of the query words,
+	// newest first, like the server search results are ordered.
+	[[nodiscard]] MessageIdsList search(
+		const QString &query,
+		PeerData *from) const;
+
+private:
+	using Items = base::flat_set<not_null<HistoryItem*>>;
+
+	[[nodiscard]] Items findByPrefix(const QString &prefix) const;
+	[[nodiscard]] int64 countMemoryUsage() const;
+
+	std::map<QString, Items> _itemsByWord;
+	std::unordered_map<not_null<HistoryItem*>, QStringList> _wordsByItem;
+
+	int _updates = 0;
+	crl::time _updatesDuration = 0;
+
+};
+
+} // namespace Data
@@ -74,6 +74,7 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include "base/unixtime.h"
 #include "base/call_delayed.h"
 #include "base/random.h"
+#include "base/options.h"
 #include "spellcheck/spellcheck_highlight_syntax.h"
 
 namespace Data {
@@ -81,6 +82,13 @@ namespace {
 
 using ViewElement = HistoryView::Element;
 
+base::options::toggle OptionUnbatchedChatListRefreshes({
+	.id = kOptionUnbatchedChatListRefreshes,
+	.name = "Unbatched chats list refreshes",
+	.description = "Reorder the chats list after each message "
+		"while applying a difference, to compare with the batched mode.",
+});
+
 // s: box 100x100
 // m: box 320x320
 // x: box 800x800
@@ -230,6 +238,9 @@ std::vector<UnavailableReason> ExtractUnavailableReasons(
 
 } // namespace
 
+const char kOptionUnbatchedChatListRefreshes[]
+	= "unbatched-chat-list-refreshes";
+
 Session::Session(not_null<Main::Session*> session)
 : _session(session)
 , _cache(Core::App().databases().get(
@@ -380,8 +391,8 @@ void Session::clear() {
 	_scheduledMessages = nullptr;
 	_sponsoredMessages = nullptr;
 	_dependentMessages.clear();
-	base::take(_messages);
-	base::take(_nonChannelMessages);
+	_messages.clear();
+	_nonChannelMessages.clear();
 	_messageByRandomId.clear();
 	_sentMessagesData.clear();
 	cSetRecentInlineBots(RecentInlineBots());
@@ -1627,27 +1638,24 @@ rpl::producer<not_null<HistoryItem*>> Session::newItemAdded() const {
 }
 
 HistoryItem *Session::changeMessageId(PeerId peerId, MsgId wasId, MsgId nowId) {
-	const auto list = messagesListForInsert(peerId);
-	const auto i = list->find(wasId);
-	if (i == list->end()) {
+	const auto item = _messages.find({ peerId, wasId });
+	if (!item) {
 		return nullptr;
 	}
-	const auto item = i->second;
-	list->erase(i);
-	const auto &[j, ok] = list->emplace(nowId, item);
+	Assert(!_messages.find({ peerId, nowId }));
+	_messages.remove({ peerId, wasId });
+	_messages.set({ peerId, nowId }, item);
 
 	if (!peerIsChannel(peerId)) {
 		if (IsServerMsgId(wasId)) {
-			const auto k = _nonChannelMessages.find(wasId);
-			Assert(k != end(_nonChannelMessages));
-			_nonChannelMessages.erase(k);
+			Assert(_nonChannelMessages.find({ PeerId(), wasId }) != nullptr);
+			_nonChannelMessages.remove({ PeerId(), wasId });
 		}
 		if (IsServerMsgId(nowId)) {
-			_nonChannelMessages.emplace(nowId, item);
+			_nonChannelMessages.set({ PeerId(), nowId }, item);
 		}
 	}
 
-	Ensures(ok);
 	return item;
 }
 
@@ -1931,6 +1939,51 @@ void Session::unloadHeavyViewParts(
 	}
 }
 
+void Session::registerTextLayoutViewPart(not_null<ViewElement*> view) {
+	_textLayoutViewParts[view->delegate()].emplace(view);
+}
+
+void Session::unloadTextLayoutViewPart(not_null<ViewElement*> view) {
+	const auto i = _textLayoutViewParts.find(view->delegate());
+	if (i != end(_textLayoutViewParts)
+		&& i->second.contains(view)
+		&& view->unloadTextLayout()) {
+		i->second.erase(view);
+		if (i->second.empty()) {
+			_textLayoutViewParts.erase(i);
+		}
+	}
+}
+
+void Session::unloadTextLayoutViewParts(
+		not_null<HistoryView::ElementDelegate*> delegate,
+		int from,
+		int till) {
+	const auto i = _textLayoutViewParts.find(delegate);
+	if (i == end(_textLayoutViewParts)) {
+		return;
+	}
+	auto &views = i->second;
+	for (auto j = begin(views); j != end(views);) {
+		const auto view = *j;
+		if (!delegate->elementIntersectsRange(view, from, till)
+			&& view->unloadTextLayout()) {
+			j = views.erase(j);
+		} else {
+			++j;
+		}
+	}
+	if (views.empty()) {
+		_textLayoutViewParts.erase(i);
+	}
+}
+
+int Session::textLayoutViewPartsCount(
+		not_null<HistoryView::ElementDelegate*> delegate) const {
+	const auto i = _textLayoutViewParts.find(delegate);
+	return (i != end(_textLayoutViewParts)) ? int(i->second.size()) : 0;
+}
+
 void Session::registerShownSpoiler(not_null<ViewElement*> view) {
 	_shownSpoilers.emplace(view);
 }
@@ -2348,29 +2401,17 @@ void Session::processExistingMessages(
 	});
 }
 
-const Session::Messages *Session::messagesList(PeerId peerId) const {
-	const auto i = _messages.find(peerId);
-	return (i != end(_messages)) ? &i->second : nullptr;
-}
-
-auto Session::messagesListForInsert(PeerId peerId)
--> not_null<Messages*> {
-	return &_messages[peerId];
-}
-
 void Session::registerMessage(not_null<HistoryItem*> item) {
 	const auto peerId = item->history()->peer->id;
-	const auto list = messagesListForInsert(peerId);
 	const auto itemId = item->id;
-	const auto i = list->find(itemId);
-	if (i != list->end()) {
+	if (const auto existing = _messages.find({ peerId, itemId })) {
 		LOG(("App Error: Trying to re-registerMessage()."));
-		i->second->destroy();
+		existing->destroy();
 	}
-	list->emplace(itemId, item);
+	_messages.set({ peerId, itemId }, item);
 
 	if (!peerIsChannel(peerId) && IsServerMsgId(itemId)) {
-		_nonChannelMessages.emplace(itemId, item);
+		_nonChannelMessages.set({ PeerId(), itemId }, item);
 	}
 }
 
@@ -2428,18 +2469,18 @@ void Session::checkTTLs() {
 void Session::processMessagesDeleted(
 		PeerId peerId,
 		const QVector<MTPint> &data) {
-	const auto list = messagesList(peerId);
+	session().local().historyCacheMessagesDeleted(peerId, data);
+
 	const auto affected = historyLoaded(peerId);
-	if (!list && !affected) {
+	if (_messages.empty() && !affected) {
 		return;
 	}
 
 	auto historiesToCheck = base::flat_set<not_null<History*>>();
 	for (const auto &messageId : data) {
-		const auto i = list ? list->find(messageId.v) : Messages::iterator();
-		if (list && i != list->end()) {
-			const auto history = i->second->history();
-			i->second->destroy();
+		if (const auto item = _messages.find({ peerId, messageId.v })) {
+			const auto history = item->history();
+			item->destroy();
 			if (!history->chatListMessageKnown()) {
 				historiesToCheck.emplace(history);
 			}
@@ -2454,15 +2495,24 @@ void Session::processMessagesDeleted(
 
 void Session::processNonChannelMessagesDeleted(const QVector<MTPint> &data) {
 	auto historiesToCheck = base::flat_set<not_null<History*>>();
+	auto unknown = QVector<MTPint>();
 	for (const auto &messageId : data) {
 		if (const auto item = nonChannelMessage(messageId.v)) {
 			const auto history = item->history();
+			session().local().historyCacheMessagesDeleted(
+				history->peer->id,
+				{ messageId });
 			item->destroy();
 			if (!history->chatListMessageKnown()) {
 				historiesToCheck.emplace(history);
 			}
+		} else {
+			unknown.push_back(messageId);
 		}
 	}
+	if (!unknown.isEmpty()) {
+		session().local().historyCacheMessagesDeleted(PeerId(), unknown);
+	}
 	for (const auto &history : historiesToCheck) {
 		history->requestChatListMessage();
 	}
@@ -2503,10 +2553,10 @@ void Session::unregisterMessage(not_null<HistoryItem*> item) {
 			++i;
 		}
 	}
-	messagesListForInsert(peerId)->erase(itemId);
+	_messages.remove({ peerId, itemId });
 
 	if (!peerIsChannel(peerId) && IsServerMsgId(itemId)) {
-		_nonChannelMessages.erase(itemId);
+		_nonChannelMessages.remove({ PeerId(), itemId });
 	}
 }
 
@@ -2531,17 +2581,7 @@ bool Session::suggestToGigagroup(not_null<ChannelData*> group) const {
 }
 
 HistoryItem *Session::message(PeerId peerId, MsgId itemId) const {
-	if (!itemId) {
-		return nullptr;
-	}
-
-	const auto data = messagesList(peerId);
-	if (!data) {
-		return nullptr;
-	}
-
-	const auto i = data->find(itemId);
-	return (i != data->end()) ? i->second.get() : nullptr;
+	return itemId ? _messages.find({ peerId, itemId }) : nullptr;
 }
 
 HistoryItem *Session::message(
@@ -2558,8 +2598,7 @@ HistoryItem *Session::nonChannelMessage(MsgId itemId) const {
 	if (!IsServerMsgId(itemId)) {
 		return nullptr;
 	}
-	const auto i = _nonChannelMessages.find(itemId);
-	return (i != end(_nonChannelMessages)) ? i->second.get() : nullptr;
+	return _nonChannelMessages.find({ PeerId(), itemId });
 }
 
 void Session::updateDependentMessages(not_null<HistoryItem*> item) {
@@ -4184,6 +4223,13 @@ void Session::unregisterItemView(not_null<ViewElement*> view) {
 	Expects(!_heavyViewParts.contains(view));
 
 	_shownSpoilers.remove(view);
+	if (const auto i = _textLayoutViewParts.find(view->delegate())
+		; i != end(_textLayoutViewParts)) {
+		i->second.erase(view);
+		if (i->second.empty()) {
+			_textLayoutViewParts.erase(i);
+		}
+	}
 
 	const auto i = _views.find(view->data());
 	if (i != end(_views)) {
@@ -4273,6 +4319,12 @@ void Session::refreshChatListEntry(Dialogs::Key key) {
 	const auto history = entry->asHistory();
 	const auto topic = entry->asTopic();
 	const auto mainList = chatsListFor(entry);
+	if (_chatListRefreshesHeld && history && entry->inChatList()) {
+		if (!_chatListRefreshesPostponed.emplace(history).second) {
+			++_chatListRefreshesSkipped;
+		}
+		return;
+	}
 	auto event = ChatListEntryRefresh{ .key = key };
 	const auto creating = event.existenceChanged = !entry->inChatList();
 	if (creating && topic && topic->creating()) {
@@ -4330,6 +4382,8 @@ void Session::removeChatListEntry(Dialogs::Key key) {
 	const auto entry = key.entry();
 	if (!entry->inChatList()) {
 		return;
+	} else if (const auto history = entry->asHistory()) {
+		_chatListRefreshesPostponed.remove(history);
 	}
 	Assert(entry->folderKnown());
 
@@ -4362,6 +4416,47 @@ void Session::removeChatListEntry(Dialogs::Key key) {
 	}
 }
 
+Session::ChatListRefreshesHold::ChatListRefreshesHold(Session *owner)
+: _owner(owner) {
+	if (_owner) {
+		++_owner->_chatListRefreshesHeld;
+	}
+}
+
+Session::ChatListRefreshesHold::~ChatListRefreshesHold() {
+	if (_owner) {
+		_owner->releaseChatListRefreshes();
+	}
+}
+
+auto Session::holdChatListRefreshes() -> ChatListRefreshesHold {
+	return ChatListRefreshesHold(chatListRefreshesBatched() ? this : nullptr);
+}
+
+bool Session::chatListRefreshesBatched() const {
+	return !OptionUnbatchedChatListRefreshes.value();
+}
+
+void Session::releaseChatListRefreshes() {
+	Expects(_chatListRefreshesHeld > 0);
+
+	if (--_chatListRefreshesHeld > 0) {
+		return;
+	}
+	const auto postponed = base::take(_chatListRefreshesPostponed);
+	const auto skipped = base::take(_chatListRefreshesSkipped);
+	for (const auto &history : postponed) {
+		if (history->inChatList()) {
+			refreshChatListEntry(history);
+		}
+	}
+	if (skipped) {
+		DEBUG_LOG(("Chats Info: %1 chat list refreshes applied, %2 skipped."
+			).arg(postponed.size()
+			).arg(skipped));
+	}
+}
+
 auto Session::chatListEntryRefreshes() const
 -> rpl::producer<ChatListEntryRefresh> {
 	return _chatListEntryRefreshes.events();
@@ -11,6 +11,7 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include "dialogs/dialogs_main_list.h"
 #include "data/data_groups.h"
 #include "data/data_cloud_file.h"
+#include "data/data_messages_registry.h"
 #include "history/history_location_manager.h"
 #include "base/timer.h"
 
@@ -63,6 +64,8 @@ class CustomEmojiManager;
 class Stories;
 class SavedMessages;
 
+extern const char kOptionUnbatchedChatListRefreshes[];
+
 struct RepliesReadTillUpdate {
 	FullMsgId id;
 	MsgId readTillId;
@@ -313,6 +316,15 @@ public:
 		int from,
 		int till);
 
+	void registerTextLayoutViewPart(not_null<ViewElement*> view);
+	void unloadTextLayoutViewPart(not_null<ViewElement*> view);
+	void unloadTextLayoutViewParts(
+		not_null<HistoryView::ElementDelegate*> delegate,
+		int from,
+		int till);
+	[[nodiscard]] int textLayoutViewPartsCount(
+		not_null<HistoryView::ElementDelegate*> delegate) const;
+
 	void registerShownSpoiler(not_null<ViewElement*> view);
 	void hideShownSpoilers();
 
@@ -700,6 +712,23 @@ public:
 	};
 	void refreshChatListEntry(Dialogs::Key key);
 	void removeChatListEntry(Dialogs::Key key);
+
+	// While alive, repositioning of histories already in the chats list
+	// is postponed and done once per history when the last one dies.
+	class ChatListRefreshesHold final {
+	public:
+		explicit ChatListRefreshesHold(Session *owner);
+		ChatListRefreshesHold(const ChatListRefreshesHold &) = delete;
+		ChatListRefreshesHold &operator=(
+			const ChatListRefreshesHold &) = delete;
+		~ChatListRefreshesHold();
+
+	private:
+		Session *_owner = nullptr;
+
+	};
+	[[nodiscard]] ChatListRefreshesHold holdChatListRefreshes();
+	[[nodiscard]] bool chatListRefreshesBatched() const;
 	[[nodiscard]] auto chatListEntryRefreshes() const
 		-> rpl::producer<ChatListEntryRefresh>;
 
@@ -745,7 +774,6 @@ public:
 	void clearLocalStorage();
 
 private:
-	using Messages = std::unordered_map<MsgId, not_null<HistoryItem*>>;
 
 	void suggestStartExport();
 
@@ -755,6 +783,7 @@ private:
 	void setupUserIsContactViewer();
 
 	void checkSelfDestructItems();
+	void releaseChatListRefreshes();
 	void checkLocalUsersWentOffline();
 
 	void scheduleNextTTLs();
@@ -768,8 +797,6 @@ private:
 		Folder *requestFolder,
 		const MTPDdialogFolder &data);
 
-	const Messages *messagesList(PeerId peerId) const;
-	not_null<Messages*> messagesListForInsert(PeerId peerId);
 	not_null<HistoryItem*> registerMessage(
 		std::unique_ptr<HistoryItem> item);
 	HistoryItem *changeMessageId(PeerId peerId, MsgId wasId, MsgId nowId);
@@ -907,6 +934,9 @@ private:
 	rpl::event_stream<MegagroupParticipant> _megagroupParticipantAdded;
 	rpl::event_stream<DialogsRowReplacement> _dialogsRowReplacements;
 	rpl::event_stream<ChatListEntryRefresh> _chatListEntryRefreshes;
+	base::flat_set<not_null<History*>> _chatListRefreshesPostponed;
+	int _chatListRefreshesHeld = 0;
+	int _chatListRefreshesSkipped = 0;
 	rpl::event_stream<> _unreadBadgeChanges;
 	rpl::event_stream<RepliesReadTillUpdate> _repliesReadTillUpdates;
 
@@ -915,14 +945,14 @@ private:
 	Dialogs::IndexedList _contactsNoChatsList;
 
 	MsgId _localMessageIdCounter = StartClientMsgId;
-	std::unordered_map<PeerId, Messages> _messages;
+	MessagesRegistry _messages;
 	std::map<
 		not_null<HistoryItem*>,
 		base::flat_set<not_null<HistoryItem*>>> _dependentMessages;
 	std::map<TimeId, base::flat_set<not_null<HistoryItem*>>> _ttlMessages;
 	base::Timer _ttlCheckTimer;
 
-	std::unordered_map<MsgId, not_null<HistoryItem*>> _nonChannelMessages;
+	MessagesRegistry _nonChannelMessages; // By MsgId with empty PeerId.
 
 	base::flat_map<uint64, FullMsgId> _messageByRandomId;
 	base::flat_map<uint64, SentData> _sentMessagesData;
@@ -1002,6 +1032,9 @@ private:
 	rpl::event_stream<> _pinnedDialogsOrderUpdated;
 
 	base::flat_set<not_null<ViewElement*>> _heavyViewParts;
+	base::flat_map<
+		not_null<HistoryView::ElementDelegate*>,
+		std::unordered_set<not_null<ViewElement*>>> _textLayoutViewParts;
 
 	base::flat_map<uint64, not_null<GroupCall*>> _groupCalls;
 	rpl::event_stream<InviteToCall> _invitesToCalls;
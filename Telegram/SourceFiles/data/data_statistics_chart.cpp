@@ -42,6 +42,7 @@ void StatisticalChart::measure() {
 			minValue = line.minValue;
 		}
 		line.segmentTree = Statistic::SegmentTree(line.y);
+		line.levelsOfDetail = Statistic::LevelsOfDetail(line.y);
 	}
 
 	daysLookup.clear();
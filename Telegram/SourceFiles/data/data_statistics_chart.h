@@ -7,6 +7,7 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 */
 #pragma once
 
+#include "statistics/chart_levels_of_detail.h"
 #include "statistics/segment_tree.h"
 
 namespace Data {
@@ -33,6 +34,7 @@ struct StatisticalChart {
 		std::vector<int> y;
 
 		Statistic::SegmentTree segmentTree;
+		Statistic::LevelsOfDetail levelsOfDetail;
 		int id = 0;
 		QString idString;
 		QString name;
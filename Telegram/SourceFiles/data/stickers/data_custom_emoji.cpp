@@ -89,6 +89,14 @@ private:
 		: FrameSizeFromTag(tag);
 }
 
+// Document base cache keys use only the low 17 bits of the high part, the
+// low part gets the lottie size tag and the streaming slice numbers added.
+// So size overrides go to the upper bits of the high part, which are zero
+// in the sliced and lottie keys of every document.
+[[nodiscard]] uint64 SizeOverrideCacheKeyHigh(int sizeOverride) {
+	return uint64(sizeOverride & 0xFFFF) << 24;
+}
+
 [[nodiscard]] QString InternalPrefix() {
 	return u"internal:"_q;
 }
@@ -271,10 +279,11 @@ Storage::Cache::Key CustomEmojiLoader::cacheKey(
 		return {};
 	}
 	return Storage::Cache::Key{
-		baseKey.high,
-		baseKey.low + ChatHelpers::LottieCacheKeyShift(
-			0x0F,
-			LottieSizeFromTag(_tag)),
+		baseKey.high | SizeOverrideCacheKeyHigh(_sizeOverride),
+		(baseKey.low
+			+ ChatHelpers::LottieCacheKeyShift(
+				0x0F,
+				LottieSizeFromTag(_tag))),
 	};
 }
 
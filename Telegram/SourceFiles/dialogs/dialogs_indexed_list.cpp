@@ -12,6 +12,23 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include "history/history.h"
 
 namespace Dialogs {
+namespace {
+
+constexpr auto kPrefixLength = 3;
+
+[[nodiscard]] base::flat_set<QString> CollectPrefixes(
+		const base::flat_set<QString> &words) {
+	auto result = base::flat_set<QString>();
+	result.reserve(words.size());
+	for (const auto &word : words) {
+		if (word.size() >= kPrefixLength) {
+			result.emplace(word.left(kPrefixLength));
+		}
+	}
+	return result;
+}
+
+} // namespace
 
 IndexedList::IndexedList(SortMode sortMode, FilterId filterId)
 : _sortMode(sortMode)
@@ -33,6 +50,7 @@ RowsByLetter IndexedList::addToEnd(Key key) {
 		}
 		result.letters.emplace(ch, j->second.addToEnd(key));
 	}
+	indexPrefixes(key);
 	return result;
 }
 
@@ -49,6 +67,7 @@ Row *IndexedList::addByName(Key key) {
 		}
 		j->second.addByName(key);
 	}
+	indexPrefixes(key);
 	return result;
 }
 
@@ -154,6 +173,7 @@ void IndexedList::adjustByName(
 			j->second.addByName(key);
 		}
 	}
+	indexPrefixes(key);
 }
 
 void IndexedList::adjustNames(
@@ -192,6 +212,48 @@ void IndexedList::adjustNames(
 			history->addChatListEntryByLetter(filterId, ch, row);
 		}
 	}
+	indexPrefixes(key);
+}
+
+void IndexedList::indexPrefixes(Key key) {
+	const auto entry = key.entry();
+	auto now = CollectPrefixes(entry->chatListNameWords());
+	auto &was = _prefixesByEntry[entry];
+	for (const auto &prefix : was) {
+		if (now.contains(prefix)) {
+			continue;
+		}
+		const auto i = _prefixIndex.find(prefix);
+		if (i != _prefixIndex.end()) {
+			i->second.erase(entry);
+			if (i->second.empty()) {
+				_prefixIndex.erase(i);
+			}
+		}
+	}
+	for (const auto &prefix : now) {
+		if (!was.contains(prefix)) {
+			_prefixIndex[prefix].emplace(entry);
+		}
+	}
+	was = std::move(now);
+}
+
+void IndexedList::unindexPrefixes(Key key) {
+	const auto i = _prefixesByEntry.find(key.entry());
+	if (i == _prefixesByEntry.end()) {
+		return;
+	}
+	for (const auto &prefix : i->second) {
+		const auto j = _prefixIndex.find(prefix);
+		if (j != _prefixIndex.end()) {
+			j->second.erase(i->first);
+			if (j->second.empty()) {
+				_prefixIndex.erase(j);
+			}
+		}
+	}
+	_prefixesByEntry.erase(i);
 }
 
 void IndexedList::remove(Key key, Row *replacedBy) {
@@ -201,12 +263,15 @@ void IndexedList::remove(Key key, Row *replacedBy) {
 				it->second.remove(key, replacedBy);
 			}
 		}
+		unindexPrefixes(key);
 	}
 }
 
 void IndexedList::clear() {
 	_list.clear();
 	_index.clear();
+	_prefixIndex.clear();
+	_prefixesByEntry.clear();
 }
 
 std::vector<not_null<Row*>> IndexedList::filtered(
@@ -229,12 +294,31 @@ std::vector<not_null<Row*>> IndexedList::filtered(
 		}
 		return result;
 	}();
+	using Entries = std::unordered_set<not_null<Entry*>>;
+	const auto byPrefix = [&]() -> const Entries* {
+		if (!minimal) {
+			return nullptr;
+		}
+		auto result = (const Entries*)nullptr;
+		for (const auto &word : words) {
+			if (word.size() < kPrefixLength) {
+				continue;
+			}
+			const auto i = _prefixIndex.find(word.left(kPrefixLength));
+			if (i == _prefixIndex.end()) {
+				static const auto kEmpty = Entries();
+				return &kEmpty;
+			} else if (!result || result->size() > i->second.size()) {
+				result = &i->second;
+			}
+		}
+		return result;
+	}();
 	auto result = std::vector<not_null<Row*>>();
 	if (!minimal || minimal->empty()) {
 		return result;
 	}
-	result.reserve(minimal->size());
-	for (const auto &row : *minimal) {
+	const auto check = [&](not_null<Row*> row) {
 		const auto &nameWords = row->entry()->chatListNameWords();
 		const auto found = [&](const QString &word) {
 			for (const auto &name : nameWords) {
@@ -244,15 +328,30 @@ std::vector<not_null<Row*>> IndexedList::filtered(
 			}
 			return false;
 		};
-		const auto allFound = [&] {
-			for (const auto &word : words) {
-				if (!found(word)) {
-					return false;
-				}
+		for (const auto &word : words) {
+			if (!found(word)) {
+				return false;
+			}
+		}
+		return true;
+	};
+	if (byPrefix && byPrefix->size() < minimal->size()) {
+		// Rows of the letter list, same as the ones from the full scan.
+		result.reserve(byPrefix->size());
+		for (const auto &entry : *byPrefix) {
+			const auto row = minimal->getRow(Key(entry));
+			if (row && check(row)) {
+				result.push_back(row);
 			}
-			return true;
-		}();
-		if (allFound) {
+		}
+		ranges::sort(result, std::less<>(), [](not_null<Row*> row) {
+			return row->index();
+		});
+		return result;
+	}
+	result.reserve(minimal->size());
+	for (const auto &row : *minimal) {
+		if (check(row)) {
 			result.push_back(row);
 		}
 	}
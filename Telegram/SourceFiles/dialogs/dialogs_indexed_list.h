@@ -90,12 +90,23 @@ private:
 		FilterId filterId,
 		not_null<History*> history,
 		const base::flat_set<QChar> &oldChars);
+	void indexPrefixes(Key key);
+	void unindexPrefixes(Key key);
 
 	SortMode _sortMode = SortMode();
 	FilterId _filterId = 0;
 	List _list, _empty;
 	base::flat_map<QChar, List> _index;
 
+	// Name word prefixes of a fixed length, to narrow longer queries
+	// without re-checking every row by the first letter.
+	base::flat_map<
+		QString,
+		std::unordered_set<not_null<Entry*>>> _prefixIndex;
+	std::unordered_map<
+		not_null<Entry*>,
+		base::flat_set<QString>> _prefixesByEntry;
+
 };
 
 } // namespace Dialogs
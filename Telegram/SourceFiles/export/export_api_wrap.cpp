@@ -22,8 +22,7 @@ namespace {
 
 constexpr auto kUserpicsSliceLimit = 100;
 constexpr auto kFileChunkSize = 128 * 1024;
-constexpr auto kFileRequestsCount = 2;
-//constexpr auto kFileNextRequestDelay = crl::time(20);
+constexpr auto kFileRequestsCount = 4;
 constexpr auto kChatsSliceLimit = 100;
 constexpr auto kMessagesSliceLimit = 100;
 constexpr auto kTopPeerSliceLimit = 100;
@@ -177,9 +176,16 @@ struct ApiWrap::FileProcess {
 	struct Request {
 		int64 offset = 0;
 		QByteArray bytes;
+		mtpRequestId requestId = 0;
 	};
 	std::deque<Request> requests;
-	mtpRequestId requestId = 0;
+	mtpRequestId requestId = 0; // File reference refresh request.
+	bool failed = false;
+
+	[[nodiscard]] Request *findRequest(int64 offset) {
+		const auto i = ranges::find(requests, offset, &Request::offset);
+		return (i != end(requests)) ? &*i : nullptr;
+	}
 };
 
 struct ApiWrap::FileProgress {
@@ -381,7 +387,11 @@ auto ApiWrap::fileRequest(const Data::FileLocation &location, int64 offset) {
 			MTP_long(offset),
 			MTP_int(kFileChunkSize))
 	)).fail([=](const MTP::Error &result) {
-		_fileProcess->requestId = 0;
+		if (_fileProcess->failed) {
+			return;
+		} else if (const auto request = _fileProcess->findRequest(offset)) {
+			request->requestId = 0;
+		}
 		if (result.type() == u"TAKEOUT_FILE_EMPTY"_q
 			&& _otherDataProcess != nullptr) {
 			filePartDone(
@@ -396,8 +406,12 @@ auto ApiWrap::fileRequest(const Data::FileLocation &location, int64 offset) {
 			filePartUnavailable();
 		} else if (result.code() == 400
 			&& result.type().startsWith(u"FILE_REFERENCE_"_q)) {
-			filePartRefreshReference(offset);
+			// The part is resent when the reference is refreshed.
+			if (!_fileProcess->requestId) {
+				filePartRefreshReference();
+			}
 		} else {
+			filePartFailed();
 			error(std::move(result));
 		}
 	}).toDC(MTP::ShiftDcId(location.dcId, MTP::kExportMediaDcShift)));
@@ -1247,8 +1261,7 @@ void ApiWrap::skipFile(uint64 randomId) {
 	}
 	LOG(("Export Info: File skipped."));
 	Assert(!_fileProcess->requests.empty());
-	Assert(_fileProcess->requestId != 0);
-	_mtp.request(base::take(_fileProcess->requestId)).cancel();
+	cancelFileParts();
 	base::take(_fileProcess)->done(QString());
 }
 
@@ -2067,7 +2080,7 @@ void ApiWrap::loadFile(
 
 	loadFilePart();
 
-	Ensures(_fileProcess->requestId != 0);
+	Ensures(!_fileProcess->requests.empty());
 }
 
 auto ApiWrap::prepareFileProcess(
@@ -2091,73 +2104,110 @@ auto ApiWrap::prepareFileProcess(
 }
 
 void ApiWrap::loadFilePart() {
-	if (!_fileProcess
-		|| _fileProcess->requestId
-		|| _fileProcess->requests.size() >= kFileRequestsCount
-		|| (_fileProcess->size > 0
-			&& _fileProcess->offset >= _fileProcess->size)) {
+	if (!_fileProcess || _fileProcess->requestId) {
 		return;
 	}
 
-	const auto offset = _fileProcess->offset;
-	_fileProcess->requests.push_back({ offset });
-	_fileProcess->requestId = fileRequest(
+	// Without a known size we can't tell where the file ends,
+	// so parts are requested one by one until an empty one.
+	const auto requestsCount = (_fileProcess->size > 0)
+		? kFileRequestsCount
+		: 1;
+	while (_fileProcess->requests.size() < requestsCount
+		&& (!_fileProcess->size
+			|| _fileProcess->offset < _fileProcess->size)) {
+		const auto offset = _fileProcess->offset;
+		_fileProcess->requests.push_back({ offset });
+		_fileProcess->offset += kFileChunkSize;
+		sendFilePart(offset);
+	}
+}
+
+void ApiWrap::sendFilePart(int64 offset) {
+	Expects(_fileProcess != nullptr);
+
+	const auto request = _fileProcess->findRequest(offset);
+	Assert(request != nullptr);
+
+	request->requestId = fileRequest(
 		_fileProcess->location,
-		_fileProcess->offset
+		offset
 	).done([=](const MTPupload_File &result) {
-		_fileProcess->requestId = 0;
 		filePartDone(offset, result);
 	}).send();
-	_fileProcess->offset += kFileChunkSize;
+}
+
+void ApiWrap::resendFileParts() {
+	Expects(_fileProcess != nullptr);
+	Expects(_fileProcess->requestId == 0);
+
+	for (const auto &request : _fileProcess->requests) {
+		if (!request.requestId && request.bytes.isEmpty()) {
+			sendFilePart(request.offset);
+		}
+	}
+	loadFilePart();
+}
 
-	if (_fileProcess->size > 0
-		&& _fileProcess->requests.size() < kFileRequestsCount) {
-		// Only one request at a time supported right now.
-		//const auto runner = _runner;
-		//crl::on_main([=] {
-		//	QTimer::singleShot(kFileNextRequestDelay, [=] {
-		//		runner([=] {
-		//			loadFilePart();
-		//		});
-		//	});
-		//});
+void ApiWrap::cancelFileParts() {
+	Expects(_fileProcess != nullptr);
+
+	for (auto &request : _fileProcess->requests) {
+		if (request.requestId) {
+			_mtp.request(base::take(request.requestId)).cancel();
+		}
+	}
+	if (_fileProcess->requestId) {
+		_mtp.request(base::take(_fileProcess->requestId)).cancel();
 	}
 }
 
+void ApiWrap::filePartFailed() {
+	Expects(_fileProcess != nullptr);
+
+	// The export stops on the first error, so other parts in flight
+	// are cancelled and their late results are ignored.
+	cancelFileParts();
+	_fileProcess->failed = true;
+}
+
 void ApiWrap::filePartDone(int64 offset, const MTPupload_File &result) {
 	Expects(_fileProcess != nullptr);
 	Expects(!_fileProcess->requests.empty());
 
-	if (result.type() == mtpc_upload_fileCdnRedirect) {
+	if (_fileProcess->failed) {
+		return;
+	} else if (result.type() == mtpc_upload_fileCdnRedirect) {
+		filePartFailed();
 		error("Cdn redirect is not supported.");
 		return;
 	}
 	const auto &data = result.c_upload_file();
 	if (data.vbytes().v.isEmpty()) {
 		if (_fileProcess->size > 0) {
+			filePartFailed();
 			error("Empty bytes received in file part.");
 			return;
 		}
 		const auto result = _fileProcess->file.writeBlock({});
 		if (!result) {
+			filePartFailed();
 			ioError(result);
 			return;
 		}
 	} else {
-		using Request = FileProcess::Request;
-		auto &requests = _fileProcess->requests;
-		const auto i = ranges::find(
-			requests,
-			offset,
-			[](const Request &request) { return request.offset; });
-		Assert(i != end(requests));
+		const auto request = _fileProcess->findRequest(offset);
+		Assert(request != nullptr);
 
-		i->bytes = data.vbytes().v;
+		request->requestId = 0;
+		request->bytes = data.vbytes().v;
 
+		auto &requests = _fileProcess->requests;
 		auto &file = _fileProcess->file;
 		while (!requests.empty() && !requests.front().bytes.isEmpty()) {
 			const auto &bytes = requests.front().bytes;
 			if (const auto result = file.writeBlock(bytes); !result) {
+				filePartFailed();
 				ioError(result);
 				return;
 			}
@@ -2184,7 +2234,7 @@ void ApiWrap::filePartDone(int64 offset, const MTPupload_File &result) {
 	process->done(process->relativePath);
 }
 
-void ApiWrap::filePartRefreshReference(int64 offset) {
+void ApiWrap::filePartRefreshReference() {
 	Expects(_fileProcess != nullptr);
 	Expects(_fileProcess->requestId == 0);
 
@@ -2199,10 +2249,11 @@ void ApiWrap::filePartRefreshReference(int64 offset) {
 			return true;
 		}).done([=](const MTPstories_Stories &result) {
 			_fileProcess->requestId = 0;
-			filePartExtractReference(offset, result);
+			filePartExtractReference(result);
 		}).send();
 		return;
 	} else if (!origin.messageId) {
+		filePartFailed();
 		error("FILE_REFERENCE error for non-message file.");
 		return;
 	}
@@ -2227,7 +2278,7 @@ void ApiWrap::filePartRefreshReference(int64 offset) {
 			return true;
 		}).done([=](const MTPmessages_Messages &result) {
 			_fileProcess->requestId = 0;
-			filePartExtractReference(offset, result);
+			filePartExtractReference(result);
 		}).send();
 	} else {
 		_fileProcess->requestId = splitRequest(
@@ -2243,18 +2294,18 @@ void ApiWrap::filePartRefreshReference(int64 offset) {
 			return true;
 		}).done([=](const MTPmessages_Messages &result) {
 			_fileProcess->requestId = 0;
-			filePartExtractReference(offset, result);
+			filePartExtractReference(result);
 		}).send();
 	}
 }
 
 void ApiWrap::filePartExtractReference(
-		int64 offset,
 		const MTPmessages_Messages &result) {
 	Expects(_fileProcess != nullptr);
 	Expects(_fileProcess->requestId == 0);
 
 	result.match([&](const MTPDmessages_messagesNotModified &data) {
+		filePartFailed();
 		error("Unexpected messagesNotModified received.");
 	}, [&](const auto &data) {
 		Expects(_selfId.has_value());
@@ -2276,13 +2327,7 @@ void ApiWrap::filePartExtractReference(
 					_fileProcess->location,
 					message.thumb().file.location);
 				if (refresh1 || refresh2) {
-					_fileProcess->requestId = fileRequest(
-						_fileProcess->location,
-						offset
-					).done([=](const MTPupload_File &result) {
-						_fileProcess->requestId = 0;
-						filePartDone(offset, result);
-					}).send();
+					resendFileParts();
 					return;
 				}
 			}
@@ -2292,7 +2337,6 @@ void ApiWrap::filePartExtractReference(
 }
 
 void ApiWrap::filePartExtractReference(
-		int64 offset,
 		const MTPstories_Stories &result) {
 	Expects(_fileProcess != nullptr);
 	Expects(_fileProcess->requestId == 0);
@@ -2309,13 +2353,7 @@ void ApiWrap::filePartExtractReference(
 				_fileProcess->location,
 				story.thumb().file.location);
 			if (refresh1 || refresh2) {
-				_fileProcess->requestId = fileRequest(
-					_fileProcess->location,
-					offset
-				).done([=](const MTPupload_File &result) {
-					_fileProcess->requestId = 0;
-					filePartDone(offset, result);
-				}).send();
+				resendFileParts();
 				return;
 			}
 		}
@@ -2329,6 +2367,7 @@ void ApiWrap::filePartUnavailable() {
 
 	LOG(("Export Error: File unavailable."));
 
+	cancelFileParts();
 	base::take(_fileProcess)->done(QString());
 }
 
@@ -39,6 +39,7 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include "data/data_user.h"
 #include "data/data_document.h"
 #include "data/data_histories.h"
+#include "data/data_messages_search_index.h"
 #include "lang/lang_keys.h"
 #include "apiwrap.h"
 #include "api/api_chat_participants.h"
@@ -67,6 +68,8 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 namespace {
 
 constexpr auto kNewBlockEachMessage = 50;
+constexpr auto kResizeImmediatelyBlocks = 2;
+constexpr auto kResizeDeferredDuration = crl::time(8);
 constexpr auto kSkipCloudDraftsFor = TimeId(2);
 
 using UpdateFlag = Data::HistoryUpdate::Flag;
@@ -114,6 +117,10 @@ void History::setHasPendingResizedItems() {
 	_flags |= Flag::HasPendingResizedItems;
 }
 
+bool History::hasDeferredResizes() const {
+	return _flags & Flag::HasDeferredResizes;
+}
+
 void History::itemRemoved(not_null<HistoryItem*> item) {
 	if (item == _joinedMessage) {
 		_joinedMessage = nullptr;
@@ -167,6 +174,29 @@ void History::itemVanished(not_null<HistoryItem*> item) {
 	}
 }
 
+void History::itemTextUpdated(not_null<HistoryItem*> item) {
+	// Skip items that are still being constructed, see insertItem().
+	if (const auto index = _searchIndex.lock()) {
+		if (owner().message(peer->id, item->id) == item) {
+			index->update(item);
+		}
+	}
+}
+
+auto History::searchIndex() -> std::shared_ptr<Data::MessagesSearchIndex> {
+	if (auto result = _searchIndex.lock()) {
+		return result;
+	}
+	auto items = std::vector<not_null<HistoryItem*>>();
+	items.reserve(_messages.size());
+	for (const auto &item : _messages) {
+		items.push_back(item.get());
+	}
+	auto result = std::make_shared<Data::MessagesSearchIndex>(items);
+	_searchIndex = result;
+	return result;
+}
+
 void History::takeLocalDraft(not_null<History*> from) {
 	const auto topicRootId = MsgId(0);
 	const auto i = from->_drafts.find(Data::DraftKey::Local(topicRootId));
@@ -469,6 +499,9 @@ not_null<HistoryItem*> History::insertItem(
 
 	const auto result = i->get();
 	owner().registerMessage(result);
+	if (const auto index = _searchIndex.lock()) {
+		index->update(result);
+	}
 
 	Ensures(ok);
 	return result;
@@ -504,6 +537,9 @@ void History::destroyMessage(not_null<HistoryItem*> item) {
 
 	owner().unregisterMessage(item);
 	Core::App().notifications().clearFromItem(item);
+	if (const auto index = _searchIndex.lock()) {
+		index->remove(item);
+	}
 
 	auto hack = std::unique_ptr<HistoryItem>(item.get());
 	const auto i = _messages.find(hack);
@@ -3048,16 +3084,71 @@ void History::resizeToWidth(int newWidth) {
 		: (_width != newWidth)
 		? Request::ResizeAll
 		: Request::ResizePending;
-	if (request == Request::ResizePending && !hasPendingResizedItems()) {
+	if (request == Request::ResizePending
+		&& !hasPendingResizedItems()
+		&& !hasDeferredResizes()) {
 		return;
 	}
-	_flags &= ~(Flag::HasPendingResizedItems | Flag::PendingAllItemsResize);
+	_flags &= ~(Flag::HasPendingResizedItems
+		| Flag::PendingAllItemsResize
+		| Flag::HasDeferredResizes);
 
 	_width = newWidth;
+
+	// Blocks laid out for another width keep their old heights for now,
+	// or take them from the messages heights cached for the new width.
+	// The ones around the scroll top item are resized right away, others
+	// are resized closest first until the time limit, the rest is left
+	// for the next call, see hasDeferredResizes().
+	const auto started = crl::now();
+	auto stale = std::vector<int>();
+	for (auto i = 0, count = int(blocks.size()); i != count; ++i) {
+		const auto block = blocks[i].get();
+		if (request != Request::ReinitAll
+			&& block->width() > 0
+			&& block->width() != newWidth) {
+			stale.push_back(i);
+		} else {
+			block->resizeGetHeight(newWidth, (block->width() > 0)
+				? request
+				: Request::ResizeAll);
+		}
+	}
+	if (!stale.empty()) {
+		const auto around = scrollTopItem
+			? scrollTopItem->block()->indexInHistory()
+			: (int(blocks.size()) - 1);
+		const auto distance = [&](int index) {
+			return std::abs(index - around);
+		};
+		ranges::sort(stale, ranges::less(), distance);
+		auto resized = 0;
+		auto cached = 0;
+		for (const auto index : stale) {
+			const auto block = blocks[index].get();
+			if (distance(index) > kResizeImmediatelyBlocks
+				&& crl::now() - started >= kResizeDeferredDuration) {
+				_flags |= Flag::HasDeferredResizes;
+				if (block->applyCachedHeight(newWidth)) {
+					++cached;
+				}
+			} else {
+				block->resizeGetHeight(newWidth, Request::ResizeAll);
+				++resized;
+			}
+		}
+		DEBUG_LOG(("History Info: resized %1 of %2 stale blocks to %3 "
+			"in %4ms, deferred with cached heights: %5."
+			).arg(resized
+			).arg(stale.size()
+			).arg(newWidth
+			).arg(crl::now() - started
+			).arg(cached));
+	}
 	int y = 0;
 	for (const auto &block : blocks) {
 		block->setY(y);
-		y += block->resizeGetHeight(newWidth, request);
+		y += block->height();
 	}
 	_height = y;
 }
@@ -3415,6 +3506,7 @@ void History::clear(ClearType type) {
 		}
 		clearNotifications();
 		owner().notifyHistoryCleared(this);
+		session().local().clearHistoryCache(this);
 		if (unreadCountKnown()) {
 			setUnreadCount(0);
 		}
@@ -3584,10 +3676,24 @@ int HistoryBlock::resizeGetHeight(int newWidth, ResizeRequest request) {
 				: message->height();
 		}
 	}
+	_width = newWidth;
 	_height = y;
 	return _height;
 }
 
+bool HistoryBlock::applyCachedHeight(int newWidth) {
+	auto result = 0;
+	for (const auto &message : messages) {
+		const auto height = message->cachedHeight(newWidth);
+		if (!height) {
+			return false;
+		}
+		result += *height;
+	}
+	_height = result;
+	return true;
+}
+
 void HistoryBlock::remove(not_null<Element*> view) {
 	Expects(view->block() == this);
 
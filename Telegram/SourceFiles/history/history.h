@@ -35,6 +35,7 @@ class Folder;
 class ChatFilter;
 struct SponsoredFrom;
 class SponsoredMessages;
+class MessagesSearchIndex;
 
 enum class ForwardOptions {
 	PreserveInfo,
@@ -300,9 +301,16 @@ public:
 
 	void itemRemoved(not_null<HistoryItem*> item);
 	void itemVanished(not_null<HistoryItem*> item);
+	void itemTextUpdated(not_null<HistoryItem*> item);
+
+	// Created on the first use from all the loaded messages,
+	// destroyed when the last search holding it is closed.
+	[[nodiscard]] auto searchIndex()
+		-> std::shared_ptr<Data::MessagesSearchIndex>;
 
 	bool hasPendingResizedItems() const;
 	void setHasPendingResizedItems();
+	[[nodiscard]] bool hasDeferredResizes() const;
 
 	[[nodiscard]] auto sendActionPainter()
 	-> not_null<HistoryView::SendActionPainter*> override {
@@ -470,6 +478,7 @@ private:
 		FakeUnreadWhileOpened = (1 << 4),
 		HasPinnedMessages = (1 << 5),
 		ResolveChatListMessage = (1 << 6),
+		HasDeferredResizes = (1 << 7),
 	};
 	using Flags = base::flags<Flag>;
 	friend inline constexpr auto is_flag_type(Flag) {
@@ -613,6 +622,7 @@ private:
 	std::optional<HistoryItem*> _lastServerMessage;
 	base::flat_set<not_null<HistoryItem*>> _clientSideMessages;
 	std::unordered_set<std::unique_ptr<HistoryItem>> _messages;
+	std::weak_ptr<Data::MessagesSearchIndex> _searchIndex;
 
 	// This almost always is equal to _lastMessage. The only difference is
 	// for a group that migrated to a supergroup. Then _lastMessage can
@@ -665,6 +675,14 @@ public:
 	void refreshView(not_null<Element*> view);
 
 	int resizeGetHeight(int newWidth, ResizeRequest request);
+
+	// Takes the height from the messages cached heights for that width,
+	// keeps the old one and returns false if some of them are not known.
+	bool applyCachedHeight(int newWidth);
+
+	int width() const {
+		return _width;
+	}
 	int y() const {
 		return _y;
 	}
@@ -707,6 +725,7 @@ protected:
 	const not_null<History*> _history;
 
 	int _y = 0;
+	int _width = 0;
 	int _height = 0;
 	int _indexInHistory = -1;
 
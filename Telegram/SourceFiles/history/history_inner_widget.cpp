@@ -92,6 +92,8 @@ namespace {
 
 constexpr auto kScrollDateHideTimeout = 1000;
 constexpr auto kUnloadHeavyPartsPages = 2;
+constexpr auto kUnloadTextLayoutsPages = 4;
+constexpr auto kTextLayoutsSweepFactor = 2;
 constexpr auto kClearUserpicsAfter = 50;
 
 // Helper binary search for an item in a list that is not completely
@@ -696,6 +698,49 @@ void HistoryInner::enumerateItemsInHistory(History *history, int historytop, Met
 	}
 }
 
+template <typename Method>
+void HistoryInner::enumerateItemsInRange(
+		History *history,
+		int historytop,
+		int from,
+		int till,
+		Method method) {
+	if (historytop < 0
+		|| history->isEmpty()
+		|| till <= historytop
+		|| historytop + history->height() <= from) {
+		return;
+	}
+	const auto &blocks = history->blocks;
+	auto blockIndex = BinarySearchBlocksOrItems<true>(
+		blocks,
+		from - historytop);
+	for (const auto blocksCount = int(blocks.size())
+		; blockIndex != blocksCount
+		; ++blockIndex) {
+		const auto block = blocks[blockIndex].get();
+		const auto blocktop = historytop + block->y();
+		if (blocktop >= till) {
+			return;
+		}
+		const auto &messages = block->messages;
+		auto itemIndex = BinarySearchBlocksOrItems<true>(
+			messages,
+			from - blocktop);
+		for (const auto itemsCount = int(messages.size())
+			; itemIndex != itemsCount
+			; ++itemIndex) {
+			const auto view = messages[itemIndex].get();
+			const auto itemtop = blocktop + view->y();
+			if (itemtop >= till) {
+				return;
+			} else if (itemtop + view->height() > from) {
+				method(view);
+			}
+		}
+	}
+}
+
 bool HistoryInner::canHaveFromUserpics() const {
 	if (_peer->isUser()
 		&& !_peer->isSelf()
@@ -903,6 +948,15 @@ void HistoryInner::paintEvent(QPaintEvent *e) {
 		mouseActionUpdate();
 	}
 
+	// Items could've moved into the visible area without its update.
+	enumerateItems<EnumItemsDirection::TopToBottom>([](
+			not_null<Element*> view,
+			int itemtop,
+			int itembottom) {
+		view->validateTextLayout();
+		return true;
+	});
+
 	Painter p(this);
 	auto clip = e->rect();
 
@@ -1798,6 +1852,60 @@ void HistoryInner::viewRemoved(not_null<const Element*> view) {
 	refresh(_dragSelFrom);
 	refresh(_dragSelTo);
 	refresh(_scrollDateLastItem);
+
+	const auto i = ranges::lower_bound(
+		_textLayoutsWindow,
+		view.get(),
+		std::less<>(),
+		[](not_null<Element*> view) -> const Element* { return view; });
+	if (i != end(_textLayoutsWindow) && i->get() == view.get()) {
+		_textLayoutsWindow.erase(i);
+	}
+}
+
+void HistoryInner::updateTextLayoutsWindow(int from, int till) {
+	// Restore the elements entering the window, unload the leaving ones.
+	auto window = std::vector<not_null<Element*>>();
+	window.reserve(_textLayoutsWindow.size());
+	const auto restore = [&](not_null<Element*> view) {
+		view->validateTextLayout();
+		window.push_back(view);
+	};
+	if (_migrated) {
+		enumerateItemsInRange(_migrated, migratedTop(), from, till, restore);
+	}
+	enumerateItemsInRange(_history, historyTop(), from, till, restore);
+	ranges::sort(window);
+
+	auto &owner = session().data();
+	for (const auto view : _textLayoutsWindow) {
+		if (!ranges::binary_search(window, view)) {
+			owner.unloadTextLayoutViewPart(view);
+		}
+	}
+	_textLayoutsWindow = std::move(window);
+
+	// Text parsed outside of the window, like in the loaded history
+	// slices, is unloaded by a full pass once there is a lot of it.
+	const auto count = [&] {
+		return owner.textLayoutViewPartsCount(_elementDelegate)
+			+ (_migratedElementDelegate
+				? owner.textLayoutViewPartsCount(_migratedElementDelegate)
+				: 0);
+	};
+	if (count() <= _textLayoutsSweepAfter) {
+		return;
+	}
+	owner.unloadTextLayoutViewParts(_elementDelegate, from, till);
+	if (_migratedElementDelegate) {
+		owner.unloadTextLayoutViewParts(
+			_migratedElementDelegate,
+			from,
+			till);
+	}
+	_textLayoutsSweepAfter = kTextLayoutsSweepFactor * std::max(
+		count(),
+		int(_textLayoutsWindow.size()));
 }
 
 void HistoryInner::mouseActionFinish(
@@ -1896,6 +2004,7 @@ void HistoryInner::mouseActionFinish(
 		&& !hasCopyRestriction(_selected.cbegin()->first)) {
 		const auto &[item, selection] = *_selected.cbegin();
 		if (const auto view = viewByItem(item)) {
+			view->validateTextLayout();
 			TextUtilities::SetClipboardText(
 				view->selectedText(selection),
 				QClipboard::Selection);
@@ -1993,6 +2102,7 @@ HistoryView::SelectedQuote HistoryInner::selectedQuote(
 	if (!view) {
 		return {};
 	}
+	view->validateTextLayout();
 	return view->selectedQuote(_selected.begin()->second);
 }
 
@@ -2829,6 +2939,7 @@ TextForMimeData HistoryInner::getSelectedText() const {
 	if (selected.cbegin()->second != FullSelection) {
 		const auto &[item, selection] = *selected.cbegin();
 		if (const auto view = viewByItem(item)) {
+			view->validateTextLayout();
 			return view->selectedText(selection);
 		}
 		return TextForMimeData();
@@ -3097,6 +3208,12 @@ void HistoryInner::visibleAreaUpdated(int top, int bottom) {
 			from,
 			till);
 	}
+
+	// Keep text layouts only near the visible area.
+	const auto layoutPages = kUnloadTextLayoutsPages;
+	updateTextLayoutsWindow(
+		_visibleAreaTop - layoutPages * visibleAreaHeight,
+		_visibleAreaBottom + layoutPages * visibleAreaHeight);
 	checkActivation();
 
 	_emojiInteractions->visibleAreaUpdated(
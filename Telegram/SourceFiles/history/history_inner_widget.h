@@ -267,6 +267,18 @@ private:
 	template <bool TopToBottom, typename Method>
 	void enumerateItemsInHistory(History *history, int historytop, Method method);
 
+	// This function calls template method for each history item that
+	// intersects [from, till) range, from the top to the bottom.
+	//
+	// Method has "void (*Method)(not_null<Element*> view)" signature.
+	template <typename Method>
+	void enumerateItemsInRange(
+		History *history,
+		int historytop,
+		int from,
+		int till,
+		Method method);
+
 	template <EnumItemsDirection direction, typename Method>
 	void enumerateItems(Method method) {
 		constexpr auto TopToBottom = (direction == EnumItemsDirection::TopToBottom);
@@ -332,6 +344,7 @@ private:
 
 	void itemRemoved(not_null<const HistoryItem*> item);
 	void viewRemoved(not_null<const Element*> view);
+	void updateTextLayoutsWindow(int from, int till);
 
 	void touchResetSpeed();
 	void touchUpdateSpeed();
@@ -466,6 +479,10 @@ private:
 	bool _isChatWide = false;
 
 	base::flat_set<not_null<const HistoryItem*>> _animatedStickersPlayed;
+
+	// Elements with restored text layouts, sorted by address.
+	std::vector<not_null<Element*>> _textLayoutsWindow;
+	int _textLayoutsSweepAfter = 0;
 	base::flat_map<not_null<PeerData*>, Ui::PeerUserpicView> _userpics;
 	base::flat_map<not_null<PeerData*>, Ui::PeerUserpicView> _userpicsCache;
 	base::flat_map<MsgId, Ui::PeerUserpicView> _hiddenSenderUserpics;
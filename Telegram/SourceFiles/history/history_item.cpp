@@ -2102,6 +2102,7 @@ void HistoryItem::setRealId(MsgId newId) {
 		_history->unregisterClientSideMessage(this);
 	}
 	_history->owner().notifyItemIdChange({ fullId(), oldId });
+	_history->itemTextUpdated(this);
 
 	// We don't fire MessageUpdate::Flag::ReplyMarkup and update keyboard
 	// in history widget, because it can't exist for an outgoing message.
@@ -3103,6 +3104,7 @@ void HistoryItem::setTextValue(TextWithEntities text, bool force) {
 	const auto had = !_text.empty();
 	_text = std::move(text);
 	RemoveComponents(HistoryMessageTranslation::Bit());
+	_history->itemTextUpdated(this);
 	if (had || force) {
 		history()->owner().requestItemTextRefresh(this);
 	}
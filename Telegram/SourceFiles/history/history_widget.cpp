@@ -215,6 +215,7 @@ HistoryWidget::HistoryWidget(
 	controller->chatStyle()->value(lifetime(), st::historyScroll),
 	false)
 , _updateHistoryItems([=] { updateHistoryItemsByTimer(); })
+, _resizeDeferredTimer([=] { updateHistoryGeometry(); })
 , _cornerButtons(
 	_scroll.data(),
 	controller->chatStyle(),
@@ -2596,6 +2597,11 @@ void HistoryWidget::clearAllLoadRequests() {
 		histories.cancelRequest(_firstLoadRequest);
 		_firstLoadRequest = 0;
 	}
+	if (_cacheRefreshRequest) {
+		histories.cancelRequest(_cacheRefreshRequest);
+		_cacheRefreshRequest = 0;
+		dropCachedMessages();
+	}
 	if (_preloadRequest) {
 		histories.cancelRequest(_preloadRequest);
 		_preloadRequest = 0;
@@ -3224,6 +3230,10 @@ void HistoryWidget::messagesFailed(const MTP::Error &error, int requestId) {
 	} else if (_firstLoadRequest == requestId) {
 		_firstLoadRequest = 0;
 		closeCurrent();
+	} else if (_cacheRefreshRequest == requestId) {
+		_cacheRefreshRequest = 0;
+		dropCachedMessages();
+		closeCurrent();
 	} else if (_delayedShowAtRequest == requestId) {
 		_delayedShowAtRequest = 0;
 	}
@@ -3243,6 +3253,8 @@ void HistoryWidget::messagesReceived(
 			_preloadDownRequest = 0;
 		} else if (_firstLoadRequest == requestId) {
 			_firstLoadRequest = 0;
+		} else if (_cacheRefreshRequest == requestId) {
+			_cacheRefreshRequest = 0;
 		} else if (_delayedShowAtRequest == requestId) {
 			_delayedShowAtRequest = 0;
 		}
@@ -3310,6 +3322,10 @@ void HistoryWidget::messagesReceived(
 
 		historyLoaded();
 		injectSponsoredMessages();
+	} else if (_cacheRefreshRequest == requestId) {
+		_cacheRefreshRequest = 0;
+		cachedMessagesRefreshed(*histList);
+		injectSponsoredMessages();
 	} else if (_delayedShowAtRequest == requestId) {
 		if (toMigrated) {
 			_history->clear(History::ClearType::Unload);
@@ -3370,6 +3386,7 @@ bool HistoryWidget::markingContentsRead() const {
 		&& _list
 		&& _historyInited
 		&& !_firstLoadRequest
+		&& !_cacheRefreshRequest
 		&& !_delayedShowAtRequest
 		&& !_showAnimation
 		&& controller()->widget()->markingAsRead();
@@ -3382,7 +3399,7 @@ void HistoryWidget::checkActivation() {
 }
 
 void HistoryWidget::firstLoadMessages() {
-	if (!_history || _firstLoadRequest) {
+	if (!_history || _firstLoadRequest || _cacheRefreshRequest) {
 		return;
 	}
 
@@ -3427,9 +3444,11 @@ void HistoryWidget::firstLoadMessages() {
 	const auto historyHash = uint64(0);
 
 	const auto history = from;
+	const auto atBottom = (history == _history) && !offsetId && !offset;
+	const auto fromCache = atBottom && showCachedMessages();
 	const auto type = Data::Histories::RequestType::History;
 	auto &histories = history->owner().histories();
-	_firstLoadRequest = histories.sendRequest(history, type, [=](Fn<void()> finish) {
+	const auto requestId = histories.sendRequest(history, type, [=](Fn<void()> finish) {
 		return history->session().api().request(MTPmessages_GetHistory(
 			history->peer->input,
 			MTP_int(offsetId),
@@ -3440,13 +3459,119 @@ void HistoryWidget::firstLoadMessages() {
 			MTP_int(minId),
 			MTP_long(historyHash)
 		)).done([=](const MTPmessages_Messages &result) {
-			messagesReceived(history->peer, result, _firstLoadRequest);
+			if (atBottom) {
+				history->session().local().writeHistoryCache(
+					history,
+					result);
+			}
+			messagesReceived(
+				history->peer,
+				result,
+				fromCache ? _cacheRefreshRequest : _firstLoadRequest);
 			finish();
 		}).fail([=](const MTP::Error &error) {
-			messagesFailed(error, _firstLoadRequest);
+			messagesFailed(
+				error,
+				fromCache ? _cacheRefreshRequest : _firstLoadRequest);
 			finish();
 		}).send();
 	});
+	if (fromCache) {
+		_cacheRefreshRequest = requestId;
+	} else {
+		_firstLoadRequest = requestId;
+	}
+}
+
+bool HistoryWidget::showCachedMessages() {
+	Expects(_history != nullptr);
+
+	if (_migrated || !_history->isEmpty() || !_history->loadedAtBottom()) {
+		return false;
+	}
+	const auto cached = session().local().readHistoryCache(_history);
+	if (!cached) {
+		return false;
+	}
+	auto &owner = _history->owner();
+	auto messages = QVector<MTPMessage>();
+	cached->match([](const MTPDmessages_messagesNotModified &) {
+	}, [&](const auto &data) {
+		// Cached peers may be stale, only use them for unknown ones.
+		auto users = QVector<MTPUser>();
+		for (const auto &user : data.vusers().v) {
+			const auto id = user.match([](const auto &data) {
+				return UserId(data.vid().v);
+			});
+			if (!owner.userLoaded(id)) {
+				users.push_back(user);
+			}
+		}
+		auto chats = QVector<MTPChat>();
+		for (const auto &chat : data.vchats().v) {
+			const auto id = chat.match([](const MTPDchannel &data) {
+				return peerFromChannel(data.vid().v);
+			}, [](const MTPDchannelForbidden &data) {
+				return peerFromChannel(data.vid().v);
+			}, [](const auto &data) {
+				return peerFromChat(data.vid().v);
+			});
+			if (!owner.peerLoaded(id)) {
+				chats.push_back(chat);
+			}
+		}
+		owner.processUsers(MTP_vector<MTPUser>(std::move(users)));
+		owner.processChats(MTP_vector<MTPChat>(std::move(chats)));
+		messages = data.vmessages().v;
+	});
+	if (messages.isEmpty()) {
+		return false;
+	}
+	for (const auto &message : messages) {
+		const auto id = IdFromMessage(message);
+		if (!owner.message(_history->peer, id)) {
+			_cachedOnlyItems.emplace(id);
+		}
+	}
+	addMessagesToFront(_peer, messages);
+	_historyInited = false;
+	return true;
+}
+
+void HistoryWidget::cachedMessagesRefreshed(
+		const QVector<MTPMessage> &messages) {
+	Expects(_history != nullptr);
+
+	auto received = base::flat_set<MsgId>();
+	received.reserve(messages.size());
+	for (const auto &message : messages) {
+		const auto id = IdFromMessage(message);
+		received.emplace(id);
+		if (_cachedOnlyItems.remove(id)) {
+			session().data().updateEditedMessage(message);
+		}
+	}
+	dropCachedMessages();
+
+	_firstLoadRequest = -1; // hack - don't updateListSize yet
+	_history->getReadyFor(ShowAtTheEndMsgId);
+	addMessagesToFront(_peer, messages);
+	_firstLoadRequest = 0;
+
+	historyLoaded();
+}
+
+void HistoryWidget::dropCachedMessages() {
+	Expects(_history != nullptr);
+
+	// Items that were shown from the local cache but not confirmed
+	// by the server could be deleted or edited while we were offline.
+	_history->clear(History::ClearType::Unload);
+	for (const auto id : base::take(_cachedOnlyItems)) {
+		if (const auto item = session().data().message(_history->peer, id)) {
+			item->destroy();
+		}
+	}
 }
 
 void HistoryWidget::loadMessages() {
@@ -3695,6 +3820,7 @@ void HistoryWidget::visibleAreaUpdated() {
 
 void HistoryWidget::preloadHistoryIfNeeded() {
 	if (_firstLoadRequest
+		|| _cacheRefreshRequest
 		|| _delayedShowAtRequest
 		|| _scroll->isHidden()
 		|| !_peer
@@ -3712,6 +3838,7 @@ void HistoryWidget::preloadHistoryIfNeeded() {
 
 void HistoryWidget::preloadHistoryByScroll() {
 	if (_firstLoadRequest
+		|| _cacheRefreshRequest
 		|| _delayedShowAtRequest
 		|| _scroll->isHidden()
 		|| !_peer
@@ -6107,6 +6234,10 @@ void HistoryWidget::updateListSize() {
 	Expects(_list != nullptr);
 
 	_list->recountHistoryGeometry();
+	if (_history->hasDeferredResizes()
+		|| (_migrated && _migrated->hasDeferredResizes())) {
+		_resizeDeferredTimer.callOnce(0);
+	}
 	auto washidden = _scroll->isHidden();
 	if (washidden) {
 		_scroll->show();
@@ -553,6 +553,9 @@ private:
 	void messagesFailed(const MTP::Error &error, int requestId);
 	void addMessagesToFront(not_null<PeerData*> peer, const QVector<MTPMessage> &messages);
 	void addMessagesToBack(not_null<PeerData*> peer, const QVector<MTPMessage> &messages);
+	[[nodiscard]] bool showCachedMessages();
+	void cachedMessagesRefreshed(const QVector<MTPMessage> &messages);
+	void dropCachedMessages();
 
 	void updateSendRestriction();
 	[[nodiscard]] QString computeSendRestriction() const;
@@ -698,6 +701,8 @@ private:
 	int _firstLoadRequest = 0; // Not real mtpRequestId.
 	int _preloadRequest = 0; // Not real mtpRequestId.
 	int _preloadDownRequest = 0; // Not real mtpRequestId.
+	int _cacheRefreshRequest = 0; // Not real mtpRequestId.
+	base::flat_set<MsgId> _cachedOnlyItems;
 
 	MsgId _delayedShowAtMsgId = -1;
 	TextWithEntities _delayedShowAtMsgHighlightPart;
@@ -720,6 +725,7 @@ private:
 	int _lastScrollTop = 0; // gifs optimization
 	crl::time _lastScrolled = 0;
 	base::Timer _updateHistoryItems;
+	base::Timer _resizeDeferredTimer;
 
 	crl::time _lastUserScrolled = 0;
 	bool _synteticScrollEvent = false;
@@ -646,6 +646,25 @@ bool Element::pendingResize() const {
 	return _flags & Flag::NeedsResize;
 }
 
+std::optional<int> Element::cachedHeight(int width) const {
+	if (pendingResize() || width <= 0) {
+		return std::nullopt;
+	}
+	const auto i = ranges::find(_cachedHeights, width, &CachedHeight::width);
+	return (i != end(_cachedHeights))
+		? std::make_optional(i->height)
+		: std::nullopt;
+}
+
+void Element::rememberHeight(int width, int height) {
+	const auto i = ranges::find(_cachedHeights, width, &CachedHeight::width);
+	const auto till = (i != end(_cachedHeights))
+		? i
+		: (end(_cachedHeights) - 1);
+	std::move_backward(begin(_cachedHeights), till, till + 1);
+	_cachedHeights.front() = { .width = width, .height = height };
+}
+
 bool Element::isAttachedToPrevious() const {
 	return _flags & Flag::AttachedToPrevious;
 }
@@ -1007,6 +1026,9 @@ void Element::setTextWithLinks(
 	FillTextWithAnimatedSpoilers(this, _text);
 	_textWidth = -1;
 	_textHeight = 0;
+	if (_context == Context::History && !_text.isEmpty()) {
+		history()->owner().registerTextLayoutViewPart(this);
+	}
 }
 
 void Element::validateTextSkipBlock(bool has, int width, int height) {
@@ -1228,15 +1250,29 @@ void Element::recountDisplayDateInBlocks() {
 }
 
 QSize Element::countOptimalSize() {
-	_flags &= ~Flag::NeedsResize;
+	_flags &= ~(Flag::NeedsResize | Flag::TextLayoutUnloaded);
+	_cachedHeights = {};
 	return performCountOptimalSize();
 }
 
 QSize Element::countCurrentSize(int newWidth) {
-	if (_flags & Flag::NeedsResize) {
+	if (_flags & (Flag::NeedsResize | Flag::TextLayoutUnloaded)) {
 		initDimensions();
 	}
-	return performCountCurrentSize(newWidth);
+	const auto result = performCountCurrentSize(newWidth);
+	rememberHeight(newWidth, result.height());
+	return result;
+}
+
+void Element::validateTextLayout() {
+	if (!(_flags & Flag::TextLayoutUnloaded)) {
+		return;
+	}
+	const auto was = height();
+	initDimensions();
+	if (resizeGetHeight(width()) != was) {
+		history()->owner().requestViewResize(this);
+	}
 }
 
 bool Element::countIsTopicRootReply() const {
@@ -1457,6 +1493,26 @@ void Element::itemTextUpdated() {
 	}
 }
 
+bool Element::unloadTextLayout() {
+	if (pendingResize() || (_flags & Flag::HeavyCustomEmoji)) {
+		return false;
+	} else if (_text.isEmpty()
+		|| _text.hasSpoilers()
+		|| (_flags & Flag::TextLayoutUnloaded)
+		|| (_flags & Flag::MediaOverriden)
+		|| (_flags & Flag::SpecialOnlyEmoji)) {
+		return true;
+	}
+
+	// The height stays as is, the text is parsed and laid out again from
+	// the item in validateTextLayout() or countCurrentSize().
+	_text = Ui::Text::String(st::msgMinWidth);
+	_textWidth = -1;
+	_textHeight = 0;
+	_flags |= Flag::TextLayoutUnloaded;
+	return true;
+}
+
 void Element::unloadHeavyPart() {
 	history()->owner().unregisterHeavyViewPart(this);
 	if (_media) {
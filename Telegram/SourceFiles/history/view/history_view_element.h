@@ -300,6 +300,7 @@ public:
 		TopicRootReply           = 0x0400,
 		MediaOverriden           = 0x0800,
 		HeavyCustomEmoji         = 0x1000,
+		TextLayoutUnloaded       = 0x2000,
 	};
 	using Flags = base::flags<Flag>;
 	friend inline constexpr auto is_flag_type(Flag) { return true; }
@@ -329,6 +330,9 @@ public:
 
 	void setPendingResize();
 	[[nodiscard]] bool pendingResize() const;
+
+	// Height of a recent layout for that width, if content didn't change.
+	[[nodiscard]] std::optional<int> cachedHeight(int width) const;
 	[[nodiscard]] bool isUnderCursor() const;
 
 	[[nodiscard]] bool isLastAndSelfMessage() const;
@@ -486,6 +490,13 @@ public:
 	virtual void unloadHeavyPart();
 	void checkHeavyPart();
 
+	// Returns false if the layout can't be unloaded right now.
+	[[nodiscard]] bool unloadTextLayout();
+
+	// Unloaded text is empty in text(), the list restores it before
+	// painting or reading the text of the element.
+	void validateTextLayout();
+
 	void paintCustomHighlight(
 		Painter &p,
 		const PaintContext &context,
@@ -587,6 +598,7 @@ private:
 	void recountAttachToPreviousInBlocks();
 
 	[[nodiscard]] bool countIsTopicRootReply() const;
+	void rememberHeight(int width, int height);
 
 	QSize countOptimalSize() final override;
 	QSize countCurrentSize(int newWidth) final override;
@@ -605,6 +617,11 @@ private:
 	};
 	[[nodiscard]] TextWithLinks contextDependentServiceText();
 
+	struct CachedHeight {
+		int width = 0;
+		int height = 0;
+	};
+
 	const not_null<ElementDelegate*> _delegate;
 	const not_null<HistoryItem*> _data;
 	HistoryBlock *_block = nullptr;
@@ -618,6 +635,7 @@ private:
 
 	int _y = 0;
 	int _indexInBlock = -1;
+	std::array<CachedHeight, 3> _cachedHeights;
 
 	mutable Flags _flags = Flag(0);
 	Context _context = Context();
@@ -37,6 +37,15 @@ constexpr auto kClipThreadsCount = 8;
 constexpr auto kAverageGifSize = 320 * 240;
 constexpr auto kWaitBeforeGifPause = crl::time(200);
 
+// Thread utilisation is measured in per mille over such periods.
+constexpr auto kUtilisationPeriod = crl::time(1000);
+
+// Threads busier than that don't get new readers while others can.
+constexpr auto kBusyUtilisation = 750;
+
+// Frames processed that late after their display time are counted.
+constexpr auto kFrameLateThreshold = crl::time(20);
+
 QImage PrepareFrame(
 		const FrameRequest &request,
 		const QImage &original,
@@ -127,6 +136,9 @@ public:
 	int loadLevel() const {
 		return _loadLevel;
 	}
+	int utilisation() const {
+		return _utilisation;
+	}
 	void append(Reader *reader, const Core::FileLocation &location, const QByteArray &data);
 	void start(Reader *reader);
 	void update(Reader *reader);
@@ -138,8 +150,11 @@ private:
 	void finish();
 	void callback(Reader *reader, Notification notification);
 	void clear();
+	void updateUtilisation(crl::time now);
+	void resetUtilisation();
 
 	QAtomicInt _loadLevel;
+	QAtomicInt _utilisation;
 	using ReaderPointers = QMap<Reader*, QAtomicInt>;
 	ReaderPointers _readerPointers;
 	mutable QMutex _readerPointersMutex;
@@ -163,6 +178,11 @@ private:
 	QThread *_processingInThread = nullptr;
 	bool _needReProcess = false;
 
+	crl::time _utilisationStarted = 0;
+	crl::time _busyTime = 0;
+	int _framesProcessed = 0;
+	int _framesLate = 0;
+
 };
 
 namespace {
@@ -207,13 +227,20 @@ void Reader::init(const Core::FileLocation &location, const QByteArray &data) {
 		_threadIndex = Workers.size();
 		Workers.push_back(std::make_unique<Worker>());
 	} else {
+		// Prefer the least loaded thread among the ones that are not
+		// busy by measurement, the load level is only an estimate.
 		_threadIndex = base::RandomIndex(Workers.size());
 		auto loadLevel = 0x7FFFFFFF;
+		auto busy = true;
 		for (int i = 0, l = int(Workers.size()); i < l; ++i) {
-			const auto level = Workers[i]->manager.loadLevel();
-			if (level < loadLevel) {
+			const auto &manager = Workers[i]->manager;
+			const auto level = manager.loadLevel();
+			const auto isBusy = (manager.utilisation() > kBusyUtilisation);
+			if ((busy && !isBusy)
+				|| (busy == isBusy && level < loadLevel)) {
 				_threadIndex = i;
 				loadLevel = level;
+				busy = isBusy;
 			}
 		}
 	}
@@ -894,26 +921,46 @@ void Manager::process() {
 		checkAllReaders = (_readers.size() > _readerPointers.size());
 	}
 
+	// Process the readers that wait for their frames the longest first.
+	auto due = std::vector<std::pair<crl::time, ReaderPrivate*>>();
+	for (auto i = _readers.begin(), e = _readers.end(); i != e; ++i) {
+		if (i.value() <= ms) {
+			due.emplace_back(i.value(), i.key());
+		}
+	}
+	ranges::sort(due);
+	for (const auto &[when, reader] : due) {
+		const auto i = _readers.find(reader);
+		if (i == _readers.end()) {
+			continue;
+		}
+		const auto started = crl::now();
+		if (when > 0 && started - when > kFrameLateThreshold) {
+			++_framesLate;
+		}
+		++_framesProcessed;
+		ResultHandleState state = handleResult(reader, reader->process(ms), ms);
+		ms = crl::now();
+		_busyTime += ms - started;
+		if (state == ResultHandleRemove) {
+			_readers.erase(i);
+			continue;
+		} else if (state == ResultHandleStop) {
+			_processingInThread = nullptr;
+			return;
+		}
+		if (reader->_videoPausedAtMs) {
+			i.value() = ms + 86400 * 1000ULL;
+		} else if (reader->_nextFrameWhen && reader->_started) {
+			i.value() = reader->_nextFrameWhen;
+		} else {
+			i.value() = (ms + 86400 * 1000ULL);
+		}
+	}
+
 	for (auto i = _readers.begin(), e = _readers.end(); i != e;) {
 		ReaderPrivate *reader = i.key();
-		if (i.value() <= ms) {
-			ResultHandleState state = handleResult(reader, reader->process(ms), ms);
-			if (state == ResultHandleRemove) {
-				i = _readers.erase(i);
-				continue;
-			} else if (state == ResultHandleStop) {
-				_processingInThread = nullptr;
-				return;
-			}
-			ms = crl::now();
-			if (reader->_videoPausedAtMs) {
-				i.value() = ms + 86400 * 1000ULL;
-			} else if (reader->_nextFrameWhen && reader->_started) {
-				i.value() = reader->_nextFrameWhen;
-			} else {
-				i.value() = (ms + 86400 * 1000ULL);
-			}
-		} else if (checkAllReaders) {
+		if (checkAllReaders) {
 			QMutexLocker lock(&_readerPointersMutex);
 			auto it = constUnsafeFindReaderPointer(reader);
 			if (it == _readerPointers.cend()) {
@@ -929,6 +976,12 @@ void Manager::process() {
 		++i;
 	}
 
+	if (_readers.isEmpty()) {
+		resetUtilisation();
+	} else {
+		updateUtilisation(crl::now());
+	}
+
 	ms = crl::now();
 	if (_needReProcess || minms <= ms) {
 		_needReProcess = false;
@@ -940,6 +993,42 @@ void Manager::process() {
 	_processingInThread = nullptr;
 }
 
+void Manager::updateUtilisation(crl::time now) {
+	if (!_utilisationStarted) {
+		_utilisationStarted = now;
+		return;
+	}
+	const auto elapsed = now - _utilisationStarted;
+	if (elapsed < kUtilisationPeriod) {
+		return;
+	}
+	const auto utilisation = int(std::min(
+		base::take(_busyTime) * 1000 / elapsed,
+		crl::time(1000)));
+	_utilisation.storeRelaxed(utilisation);
+	_utilisationStarted = now;
+
+	const auto processed = base::take(_framesProcessed);
+	const auto late = base::take(_framesLate);
+	if (late > 0) {
+		DEBUG_LOG(("Clip Info: %1 of %2 frames late in %3 ms, "
+			"thread utilisation: %4 per mille."
+			).arg(late
+			).arg(processed
+			).arg(elapsed
+			).arg(utilisation));
+	}
+}
+
+void Manager::resetUtilisation() {
+	// Without readers the thread is idle, don't let a stale measurement
+	// keep new readers away from it until the next period ends.
+	_utilisation.storeRelaxed(0);
+	_utilisationStarted = 0;
+	_busyTime = 0;
+	_framesProcessed = _framesLate = 0;
+}
+
 void Manager::finish() {
 	_timer.stop();
 	clear();
@@ -958,6 +1047,7 @@ void Manager::clear() {
 		delete i.key();
 	}
 	_readers.clear();
+	resetUtilisation();
 }
 
 Manager::~Manager() {
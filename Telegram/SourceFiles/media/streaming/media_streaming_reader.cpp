@@ -10,6 +10,7 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include "media/streaming/media_streaming_common.h"
 #include "media/streaming/media_streaming_loader.h"
 #include "storage/cache/storage_cache_database.h"
+#include "base/options.h"
 
 namespace Media {
 namespace Streaming {
@@ -21,7 +22,14 @@ constexpr auto kInSlice = uint32(kPartsInSlice * kPartSize);
 constexpr auto kMaxPartsInHeader = 64;
 constexpr auto kMaxOnlyInHeader = 80 * kPartSize;
 constexpr auto kPartsOutsideFirstSliceGood = 8;
-constexpr auto kSlicesInMemory = 2;
+
+// Memory budget for loaded slices of one file, the least recently used
+// slices are put to cache and unloaded when it is exceeded.
+constexpr auto kSlicesMemoryBudget = 32 * 1024 * 1024;
+constexpr auto kSlicesMemoryBudgetLarge = 128 * 1024 * 1024;
+
+// Next slice is read from cache when reading passes this slice offset.
+constexpr auto kReadAheadFromCacheOffset = kInSlice / 2;
 
 // 1 MB of parts are requested from cloud ahead of reading demand.
 constexpr auto kPreloadPartsAhead = 8;
@@ -29,6 +37,21 @@ constexpr auto kDownloaderRequestsLimit = 4;
 
 using PartsMap = base::flat_map<uint32, QByteArray>;
 
+base::options::toggle OptionLargeStreamingReadAhead({
+	.id = kOptionLargeStreamingReadAhead,
+	.name = "Larger streaming read-ahead",
+	.description = "Keep up to 128 MB of each played file in memory "
+		"instead of 32 MB, so that seeking back and forth in long "
+		"videos reads less from the cache.",
+});
+
+[[nodiscard]] int SlicesInMemory() {
+	const auto budget = OptionLargeStreamingReadAhead.value()
+		? kSlicesMemoryBudgetLarge
+		: kSlicesMemoryBudget;
+	return std::max(budget / int(kInSlice), 2);
+}
+
 struct ParsedCacheEntry {
 	PartsMap parts;
 	std::optional<PartsMap> included;
@@ -196,6 +219,8 @@ void CopyLoaded(
 
 } // namespace
 
+const char kOptionLargeStreamingReadAhead[] = "large-streaming-read-ahead";
+
 template <int Size>
 bool Reader::StackIntVector<Size>::add(uint32 value) {
 	using namespace rpl::mappers;
@@ -341,7 +366,8 @@ auto Reader::Slice::offsetsFromLoader(uint32 from, uint32 till) const
 }
 
 Reader::Slices::Slices(uint32 size, bool useCache)
-: _size(size) {
+: _size(size)
+, _slicesInMemory(SlicesInMemory()) {
 	Expects(size > 0);
 
 	if (useCache) {
@@ -628,6 +654,14 @@ auto Reader::Slices::fill(uint32 offset, bytes::span buffer) -> FillResult {
 				secondFrom,
 				secondTill);
 		}
+		if (till - (tillSlice - 1) * kInSlice >= kReadAheadFromCacheOffset
+			&& tillSlice < _data.size()
+			&& cacheNotLoaded(tillSlice)
+			&& !(_data[tillSlice].flags & Flag::LoadingFromCache)) {
+			_data[tillSlice].flags |= Flag::LoadingFromCache;
+			result.sliceNumbersFromCache.add(tillSlice + 1);
+			markSliceUsed(tillSlice);
+		}
 		result.toCache = serializeAndUnloadUnused();
 		result.state = FillState::Success;
 	} else {
@@ -713,7 +747,7 @@ Reader::SerializedSlice Reader::Slices::serializeAndUnloadUnused() {
 	using Flag = Slice::Flag;
 
 	if (_headerMode == HeaderMode::Unknown
-		|| _usedSlices.size() <= kSlicesInMemory) {
+		|| int(_usedSlices.size()) <= _slicesInMemory) {
 		return {};
 	}
 	const auto purgeSlice = _usedSlices.front();
@@ -1251,11 +1285,24 @@ Reader::FillState Reader::fill(
 	do {
 		lastResult = fillFromSlices(uint32(offset), buffer);
 		if (lastResult == FillState::Success) {
+			if (_stats.stallStarted) {
+				_stats.stalledTime += crl::now() - _stats.stallStarted;
+				_stats.stallStarted = 0;
+			}
+			++_stats.fills;
 			return done();
 		}
 		startWaiting();
 	} while (checkForSomethingMoreReceived());
 
+	if (!_stats.stallStarted && !_streamingError) {
+		_stats.stallStarted = crl::now();
+		if (lastResult == FillState::WaitingCache) {
+			++_stats.cacheStalls;
+		} else {
+			++_stats.remoteStalls;
+		}
+	}
 	return _streamingError ? failed() : lastResult;
 }
 
@@ -1270,6 +1317,7 @@ Reader::FillState Reader::fillFromSlices(uint32 offset, bytes::span buffer) {
 
 	for (const auto sliceNumber : result.sliceNumbersFromCache.values()) {
 		readFromCache(sliceNumber);
+		++_stats.cacheReads;
 	}
 
 	if (_cacheHelper && result.toCache.number >= 0) {
@@ -1393,6 +1441,17 @@ void Reader::finalizeCache() {
 
 Reader::~Reader() {
 	finalizeCache();
+
+	if (_stats.fills) {
+		DEBUG_LOG(("Streaming Info: Reader stats, "
+			"fills: %1, cache reads: %2, "
+			"stalls: %3 on cache, %4 on remote, %5 ms total."
+			).arg(_stats.fills
+			).arg(_stats.cacheReads
+			).arg(_stats.cacheStalls
+			).arg(_stats.remoteStalls
+			).arg(_stats.stalledTime));
+	}
 }
 
 QByteArray SerializeComplexPartsMap(
@@ -28,6 +28,8 @@ namespace Streaming {
 
 class Loader;
 struct LoadedPart;
+
+extern const char kOptionLargeStreamingReadAhead[];
 enum class Error;
 
 class Reader final : public base::has_weak_ptr {
@@ -199,6 +201,7 @@ private:
 		Slice _header;
 		std::deque<int> _usedSlices;
 		uint32 _size = 0;
+		int _slicesInMemory = 0;
 		HeaderMode _headerMode = HeaderMode::Unknown;
 		bool _fullInCache = false;
 
@@ -251,6 +254,17 @@ private:
 
 	Slices _slices;
 
+	// Streaming thread.
+	struct Stats {
+		int fills = 0;
+		int cacheReads = 0;
+		int cacheStalls = 0;
+		int remoteStalls = 0;
+		crl::time stalledTime = 0;
+		crl::time stallStarted = 0;
+	};
+	Stats _stats;
+
 	// Even if streaming had failed, the Reader can work for the downloader.
 	std::optional<Error> _streamingError;
 
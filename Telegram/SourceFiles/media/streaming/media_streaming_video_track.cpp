@@ -22,9 +22,29 @@ constexpr auto kDisplaySkipped = crl::time(-1);
 constexpr auto kFinishedPosition = std::numeric_limits<crl::time>::max();
 static_assert(kDisplaySkipped != kTimeUnknown);
 
+[[nodiscard]] bool IsYUV(FrameFormat format) {
+	return (format == FrameFormat::YUV420) || (format == FrameFormat::NV12);
+}
+
+// Converts YUV data straight to the requested size, if possible.
+[[nodiscard]] bool CanConvertScaled(
+		const FrameRequest &request,
+		int rotation) {
+	return !rotation
+		&& !request.blurredBackground
+		&& request.rounding.empty()
+		&& request.mask.isNull()
+		&& (request.colored.alpha() == 0)
+		&& !request.resize.isEmpty()
+		&& (request.resize == request.outer);
+}
+
 [[nodiscard]] QImage ConvertToARGB32(
 		FrameFormat format,
-		const FrameYUV &data) {
+		const FrameYUV &data,
+		QSize resize,
+		QImage storage,
+		not_null<FFmpeg::SwscalePointer*> context) {
 	Expects(data.y.data != nullptr);
 	Expects(data.u.data != nullptr);
 	Expects((format == FrameFormat::NV12) || (data.v.data != nullptr));
@@ -34,14 +54,20 @@ static_assert(kDisplaySkipped != kTimeUnknown);
 	//	resize.transpose();
 	//}
 
-	auto result = FFmpeg::CreateFrameStorage(data.size);
-	const auto swscale = FFmpeg::MakeSwscalePointer(
+	if (resize.isEmpty()) {
+		resize = data.size;
+	}
+	if (!FFmpeg::GoodStorageForFrame(storage, resize)) {
+		storage = FFmpeg::CreateFrameStorage(resize);
+	}
+	auto swscale = FFmpeg::MakeSwscalePointer(
 		data.size,
 		(format == FrameFormat::YUV420
 			? AV_PIX_FMT_YUV420P
 			: AV_PIX_FMT_NV12),
-		data.size,
-		AV_PIX_FMT_BGRA);
+		resize,
+		AV_PIX_FMT_BGRA,
+		context);
 	if (!swscale) {
 		return QImage();
 	}
@@ -59,8 +85,11 @@ static_assert(kDisplaySkipped != kTimeUnknown);
 		data.v.stride,
 		0,
 	};
-	uint8_t *dstData[AV_NUM_DATA_POINTERS] = { result.bits(), nullptr };
-	int dstLinesize[AV_NUM_DATA_POINTERS] = { int(result.bytesPerLine()), 0 };
+	uint8_t *dstData[AV_NUM_DATA_POINTERS] = { storage.bits(), nullptr };
+	int dstLinesize[AV_NUM_DATA_POINTERS] = {
+		int(storage.bytesPerLine()),
+		0,
+	};
 
 	sws_scale(
 		swscale.get(),
@@ -71,7 +100,8 @@ static_assert(kDisplaySkipped != kTimeUnknown);
 		dstData,
 		dstLinesize);
 
-	return result;
+	*context = std::move(swscale);
+	return storage;
 }
 
 } // namespace
@@ -472,10 +502,13 @@ void VideoTrackObject::rasterizeFrame(not_null<Frame*> frame) {
 			fail(Error::InvalidData);
 			return;
 		}
+		// Images are converted on demand, keep the buffers for that.
 		if (!frame->original.isNull()) {
-			frame->original = QImage();
-			for (auto &[_, prepared] : frame->prepared) {
-				prepared.image = QImage();
+			frame->storage = base::take(frame->original);
+		}
+		for (auto &[_, prepared] : frame->prepared) {
+			if (!prepared.image.isNull()) {
+				prepared.storage = base::take(prepared.image);
 			}
 		}
 		frame->format = nv12 ? FrameFormat::NV12 : FrameFormat::YUV420;
@@ -1211,10 +1244,18 @@ QImage VideoTrack::frameImage(
 			unwrapped.updateFrameRequest(instance, useRequest);
 		});
 	}
+	const auto convertScaled = frame->original.isNull()
+		&& IsYUV(frame->format)
+		&& CanConvertScaled(useRequest, _streamRotation);
 	if (frame->original.isNull()
-		&& (frame->format == FrameFormat::YUV420
-			|| frame->format == FrameFormat::NV12)) {
-		frame->original = ConvertToARGB32(frame->format, frame->yuv);
+		&& IsYUV(frame->format)
+		&& !convertScaled) {
+		frame->original = ConvertToARGB32(
+			frame->format,
+			frame->yuv,
+			QSize(),
+			base::take(frame->storage),
+			&_swscale);
 	}
 	if (GoodForRequest(
 			frame->original,
@@ -1238,13 +1279,23 @@ QImage VideoTrack::frameImage(
 				}
 			}
 		}
-		j->second.image = PrepareByRequest(
-			frame->original,
-			frame->alpha,
-			_streamAspect,
-			_streamRotation,
-			useRequest,
-			std::move(j->second.image));
+		auto storage = j->second.image.isNull()
+			? base::take(j->second.storage)
+			: base::take(j->second.image);
+		j->second.image = convertScaled
+			? ConvertToARGB32(
+				frame->format,
+				frame->yuv,
+				useRequest.resize,
+				std::move(storage),
+				&_swscale)
+			: PrepareByRequest(
+				frame->original,
+				frame->alpha,
+				_streamAspect,
+				_streamRotation,
+				useRequest,
+				std::move(storage));
 		return j->second.image;
 	}
 	return i->second.image;
@@ -1252,10 +1303,13 @@ QImage VideoTrack::frameImage(
 
 QImage VideoTrack::currentFrameImage() {
 	const auto frame = _shared->frameForPaint();
-	if (frame->original.isNull()
-		&& (frame->format == FrameFormat::YUV420
-			|| frame->format == FrameFormat::NV12)) {
-		frame->original = ConvertToARGB32(frame->format, frame->yuv);
+	if (frame->original.isNull() && IsYUV(frame->format)) {
+		frame->original = ConvertToARGB32(
+			frame->format,
+			frame->yuv,
+			QSize(),
+			base::take(frame->storage),
+			&_swscale);
 	}
 	return frame->original;
 }
@@ -1313,9 +1367,7 @@ bool VideoTrack::IsDecoded(not_null<const Frame*> frame) {
 
 bool VideoTrack::IsRasterized(not_null<const Frame*> frame) {
 	return IsDecoded(frame)
-		&& (!frame->original.isNull()
-			|| frame->format == FrameFormat::YUV420
-			|| frame->format == FrameFormat::NV12);
+		&& (!frame->original.isNull() || IsYUV(frame->format));
 }
 
 bool VideoTrack::IsStale(not_null<const Frame*> frame, crl::time trackTime) {
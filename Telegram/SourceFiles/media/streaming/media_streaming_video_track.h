@@ -79,11 +79,13 @@ private:
 
 		FrameRequest request = FrameRequest::NonStrict();
 		QImage image;
+		QImage storage; // Buffer of a previous frame image for reuse.
 	};
 	struct Frame {
 		FFmpeg::FramePointer decoded = FFmpeg::MakeFramePointer();
 		FFmpeg::FramePointer transferred;
 		QImage original;
+		QImage storage; // Buffer of a previous original for reuse.
 		FrameYUV yuv;
 		crl::time position = kTimeUnknown;
 		crl::time displayed = kTimeUnknown;
@@ -177,6 +179,9 @@ private:
 	const AVRational _streamAspect = FFmpeg::kNormalAspect;
 	std::unique_ptr<Shared> _shared;
 
+	// Main thread, for converting YUV frames to ARGB32 images.
+	FFmpeg::SwscalePointer _swscale;
+
 	using Implementation = VideoTrackObject;
 	crl::object_on_queue<Implementation> _wrapped;
 
@@ -9,6 +9,7 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 
 #include "mtproto/mtproto_dc_options.h"
 #include "mtproto/mtproto_proxy_data.h"
+#include "mtproto/details/mtproto_buffer_pool.h"
 #include "base/bytes.h"
 
 #include <QtCore/QObject>
@@ -114,6 +115,11 @@ public:
 		return _receivedQueue;
 	}
 
+	// Processed received() buffers should be returned here.
+	[[nodiscard]] virtual BufferPool &bufferPool() {
+		return _bufferPool;
+	}
+
 	template <typename Request>
 	[[nodiscard]] mtpBuffer prepareNotSecurePacket(
 		const Request &request,
@@ -149,6 +155,7 @@ Q_SIGNALS:
 
 protected:
 	BuffersQueue _receivedQueue; // list of received packets, not processed yet
+	BufferPool _bufferPool;
 	int _pingTime = 0;
 	ProxyData _proxy;
 
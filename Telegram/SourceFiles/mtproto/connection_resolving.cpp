@@ -245,5 +245,9 @@ QString ResolvingConnection::tag() const {
 	return _child ? _child->tag() : QString();
 }
 
+BufferPool &ResolvingConnection::bufferPool() {
+	return _child ? _child->bufferPool() : AbstractConnection::bufferPool();
+}
+
 } // namespace details
 } // namespace MTP
@@ -41,6 +41,8 @@ public:
 	QString transport() const override;
 	QString tag() const override;
 
+	BufferPool &bufferPool() override;
+
 private:
 	void setChild(ConnectionPointer &&child);
 	bool refreshChild();
@@ -0,0 +1,204 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop application for the Telegram messaging service.
+
+For license and copyright information please follow this link:
+https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
+*/
+#include "mtproto/details/mtproto_aes_ige.h"
+
+#ifdef Q_PROCESSOR_X86
+#ifdef Q_CC_MSVC
+#include <intrin.h>
+#else // Q_CC_MSVC
+#include <cpuid.h>
+#endif // Q_CC_MSVC
+#include <wmmintrin.h>
+#endif // Q_PROCESSOR_X86
+
+namespace MTP::details {
+namespace {
+
+#ifdef Q_PROCESSOR_X86
+
+#ifdef Q_CC_MSVC
+#define MTP_AES_NI_TARGET
+#else // Q_CC_MSVC
+#define MTP_AES_NI_TARGET __attribute__((target("sse2,aes")))
+#endif // Q_CC_MSVC
+
+constexpr auto kRounds = 14;
+constexpr auto kBlockSize = 16;
+
+using RoundKeys = __m128i[kRounds + 1];
+
+[[nodiscard]] bool DetectAesNi() {
+#ifdef Q_CC_MSVC
+	int info[4] = { 0 };
+	__cpuid(info, 1);
+	return (info[2] & (1 << 25)) != 0;
+#else // Q_CC_MSVC
+	unsigned int eax = 0, ebx = 0, ecx = 0, edx = 0;
+	return __get_cpuid(1, &eax, &ebx, &ecx, &edx)
+		&& ((ecx & bit_AES) != 0);
+#endif // Q_CC_MSVC
+}
+
+MTP_AES_NI_TARGET inline __m128i ShiftXor(__m128i key) {
+	key = _mm_xor_si128(key, _mm_slli_si128(key, 4));
+	key = _mm_xor_si128(key, _mm_slli_si128(key, 4));
+	return _mm_xor_si128(key, _mm_slli_si128(key, 4));
+}
+
+template <int Rcon>
+MTP_AES_NI_TARGET inline __m128i ExpandEven(__m128i even, __m128i odd) {
+	const auto assist = _mm_aeskeygenassist_si128(odd, Rcon);
+	return _mm_xor_si128(ShiftXor(even), _mm_shuffle_epi32(assist, 0xFF));
+}
+
+MTP_AES_NI_TARGET inline __m128i ExpandOdd(__m128i odd, __m128i even) {
+	const auto assist = _mm_aeskeygenassist_si128(even, 0x00);
+	return _mm_xor_si128(ShiftXor(odd), _mm_shuffle_epi32(assist, 0xAA));
+}
+
+MTP_AES_NI_TARGET void ExpandEncryptKey(RoundKeys &keys, const void *key) {
+	const auto data = static_cast<const __m128i*>(key);
+	keys[0] = _mm_loadu_si128(data);
+	keys[1] = _mm_loadu_si128(data + 1);
+	keys[2] = ExpandEven<0x01>(keys[0], keys[1]);
+	keys[3] = ExpandOdd(keys[1], keys[2]);
+	keys[4] = ExpandEven<0x02>(keys[2], keys[3]);
+	keys[5] = ExpandOdd(keys[3], keys[4]);
+	keys[6] = ExpandEven<0x04>(keys[4], keys[5]);
+	keys[7] = ExpandOdd(keys[5], keys[6]);
+	keys[8] = ExpandEven<0x08>(keys[6], keys[7]);
+	keys[9] = ExpandOdd(keys[7], keys[8]);
+	keys[10] = ExpandEven<0x10>(keys[8], keys[9]);
+	keys[11] = ExpandOdd(keys[9], keys[10]);
+	keys[12] = ExpandEven<0x20>(keys[10], keys[11]);
+	keys[13] = ExpandOdd(keys[11], keys[12]);
+	keys[14] = ExpandEven<0x40>(keys[12], keys[13]);
+}
+
+MTP_AES_NI_TARGET void ExpandDecryptKey(RoundKeys &keys, const void *key) {
+	RoundKeys encrypt;
+	ExpandEncryptKey(encrypt, key);
+	keys[0] = encrypt[kRounds];
+	for (auto i = 1; i != kRounds; ++i) {
+		keys[i] = _mm_aesimc_si128(encrypt[kRounds - i]);
+	}
+	keys[kRounds] = encrypt[0];
+}
+
+MTP_AES_NI_TARGET inline __m128i EncryptBlock(
+		__m128i block,
+		const RoundKeys &keys) {
+	block = _mm_xor_si128(block, keys[0]);
+	for (auto i = 1; i != kRounds; ++i) {
+		block = _mm_aesenc_si128(block, keys[i]);
+	}
+	return _mm_aesenclast_si128(block, keys[kRounds]);
+}
+
+MTP_AES_NI_TARGET inline __m128i DecryptBlock(
+		__m128i block,
+		const RoundKeys &keys) {
+	block = _mm_xor_si128(block, keys[0]);
+	for (auto i = 1; i != kRounds; ++i) {
+		block = _mm_aesdec_si128(block, keys[i]);
+	}
+	return _mm_aesdeclast_si128(block, keys[kRounds]);
+}
+
+// Both loops read the input block before writing the output one,
+// so encrypting and decrypting in place works as well.
+MTP_AES_NI_TARGET void EncryptIge(
+		const void *src,
+		void *dst,
+		uint32 len,
+		const void *key,
+		const void *iv) {
+	RoundKeys keys;
+	ExpandEncryptKey(keys, key);
+
+	const auto ivs = static_cast<const __m128i*>(iv);
+	auto previousEncrypted = _mm_loadu_si128(ivs);
+	auto previousPlain = _mm_loadu_si128(ivs + 1);
+	auto from = static_cast<const __m128i*>(src);
+	auto to = static_cast<__m128i*>(dst);
+	for (const auto till = from + (len / kBlockSize); from != till;) {
+		const auto plain = _mm_loadu_si128(from++);
+		previousEncrypted = _mm_xor_si128(
+			EncryptBlock(_mm_xor_si128(plain, previousEncrypted), keys),
+			previousPlain);
+		previousPlain = plain;
+		_mm_storeu_si128(to++, previousEncrypted);
+	}
+}
+
+MTP_AES_NI_TARGET void DecryptIge(
+		const void *src,
+		void *dst,
+		uint32 len,
+		const void *key,
+		const void *iv) {
+	RoundKeys keys;
+	ExpandDecryptKey(keys, key);
+
+	const auto ivs = static_cast<const __m128i*>(iv);
+	auto previousEncrypted = _mm_loadu_si128(ivs);
+	auto previousPlain = _mm_loadu_si128(ivs + 1);
+	auto from = static_cast<const __m128i*>(src);
+	auto to = static_cast<__m128i*>(dst);
+	for (const auto till = from + (len / kBlockSize); from != till;) {
+		const auto encrypted = _mm_loadu_si128(from++);
+		previousPlain = _mm_xor_si128(
+			DecryptBlock(_mm_xor_si128(encrypted, previousPlain), keys),
+			previousEncrypted);
+		previousEncrypted = encrypted;
+		_mm_storeu_si128(to++, previousPlain);
+	}
+}
+
+#endif // Q_PROCESSOR_X86
+
+} // namespace
+
+bool HardwareAesIgeSupported() {
+#ifdef Q_PROCESSOR_X86
+	static const auto result = DetectAesNi();
+	return result;
+#else // Q_PROCESSOR_X86
+	return false;
+#endif // Q_PROCESSOR_X86
+}
+
+void HardwareAesIgeEncrypt(
+		const void *src,
+		void *dst,
+		uint32 len,
+		const void *key,
+		const void *iv) {
+	Expects(HardwareAesIgeSupported());
+	Expects(!(len % 16));
+
+#ifdef Q_PROCESSOR_X86
+	EncryptIge(src, dst, len, key, iv);
+#endif // Q_PROCESSOR_X86
+}
+
+void HardwareAesIgeDecrypt(
+		const void *src,
+		void *dst,
+		uint32 len,
+		const void *key,
+		const void *iv) {
+	Expects(HardwareAesIgeSupported());
+	Expects(!(len % 16));
+
+#ifdef Q_PROCESSOR_X86
+	DecryptIge(src, dst, len, key, iv);
+#endif // Q_PROCESSOR_X86
+}
+
+} // namespace MTP::details
@@ -0,0 +1,33 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop application for the Telegram messaging service.
+
+For license and copyright information please follow this link:
+https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
+*/
+#pragma once
+
+#include "base/basic_types.h"
+
+namespace MTP::details {
+
+// AES-256-IGE using AES-NI instructions, if the CPU supports them.
+// Each block depends on the previous one in both directions, so the
+// gain comes from the hardware rounds, not from processing blocks in
+// parallel. The key is 32 bytes, the iv is 32 bytes, 'len' is a
+// multiple of 16 and 'src' may be equal to 'dst'.
+[[nodiscard]] bool HardwareAesIgeSupported();
+void HardwareAesIgeEncrypt(
+	const void *src,
+	void *dst,
+	uint32 len,
+	const void *key,
+	const void *iv);
+void HardwareAesIgeDecrypt(
+	const void *src,
+	void *dst,
+	uint32 len,
+	const void *key,
+	const void *iv);
+
+} // namespace MTP::details
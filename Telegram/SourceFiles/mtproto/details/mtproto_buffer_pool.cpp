@@ -0,0 +1,77 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop application for the Telegram messaging service.
+
+For license and copyright information please follow this link:
+https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
+*/
+#include "mtproto/details/mtproto_buffer_pool.h"
+
+namespace MTP::details {
+
+BufferPool::~BufferPool() {
+	if (_allocations || _reuses) {
+		DEBUG_LOG(("MTP Info: buffer pool destroyed, "
+			"allocations: %1, reuses: %2."
+			).arg(_allocations
+			).arg(_reuses));
+	}
+}
+
+int BufferPool::ClassIndex(int size) {
+	auto shift = kMinClassShift;
+	while (shift <= kMaxClassShift && (1 << shift) < size) {
+		++shift;
+	}
+	return shift - kMinClassShift;
+}
+
+mtpBuffer BufferPool::acquire(int size) {
+	Expects(size >= 0);
+
+	const auto index = ClassIndex(size);
+	if (index < kClassesCount) {
+		auto &list = _free[index];
+		if (!list.empty()) {
+			auto result = std::move(list.back());
+			list.pop_back();
+			result.resize(size);
+			++_reuses;
+			return result;
+		}
+	}
+	++_allocations;
+	auto result = mtpBuffer();
+	result.reserve((index < kClassesCount)
+		? (1 << (index + kMinClassShift))
+		: size);
+	result.resize(size);
+	return result;
+}
+
+void BufferPool::release(mtpBuffer &&buffer) {
+	auto taken = std::move(buffer);
+	const auto capacity = int(taken.capacity());
+	if (capacity < (1 << kMinClassShift) || !taken.isDetached()) {
+		return;
+	}
+
+	// Put the buffer to the largest class it can hold without reallocating.
+	auto index = std::min(ClassIndex(capacity), kClassesCount - 1);
+	if ((1 << (index + kMinClassShift)) > capacity) {
+		--index;
+	}
+	auto &list = _free[index];
+	if (list.size() < kMaxBuffersInClass) {
+		taken.resize(0);
+		list.push_back(std::move(taken));
+	}
+}
+
+void BufferPool::clear() {
+	for (auto &list : _free) {
+		list.clear();
+	}
+}
+
+} // namespace MTP::details
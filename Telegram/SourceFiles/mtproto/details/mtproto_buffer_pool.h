@@ -0,0 +1,53 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop application for the Telegram messaging service.
+
+For license and copyright information please follow this link:
+https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
+*/
+#pragma once
+
+#include "mtproto/core_types.h"
+
+#include <array>
+
+namespace MTP::details {
+
+// Keeps released packet buffers grouped by power-of-two capacity, so that
+// a connection receiving lots of similar sized packets doesn't allocate
+// a new buffer for each of them. Not thread-safe, used by the connection
+// thread only.
+class BufferPool final {
+public:
+	BufferPool() = default;
+	BufferPool(const BufferPool &other) = delete;
+	BufferPool &operator=(const BufferPool &other) = delete;
+	~BufferPool();
+
+	// Returns a buffer of exactly 'size' ints with undefined contents.
+	[[nodiscard]] mtpBuffer acquire(int size);
+	void release(mtpBuffer &&buffer);
+	void clear();
+
+	[[nodiscard]] int allocations() const {
+		return _allocations;
+	}
+	[[nodiscard]] int reuses() const {
+		return _reuses;
+	}
+
+private:
+	static constexpr auto kMinClassShift = 6; // 256 bytes.
+	static constexpr auto kMaxClassShift = 18; // 1 MB.
+	static constexpr auto kClassesCount = kMaxClassShift - kMinClassShift + 1;
+	static constexpr auto kMaxBuffersInClass = 4;
+
+	[[nodiscard]] static int ClassIndex(int size);
+
+	std::array<std::vector<mtpBuffer>, kClassesCount> _free;
+	int _allocations = 0;
+	int _reuses = 0;
+
+};
+
+} // namespace MTP::details
@@ -0,0 +1,75 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop application for the Telegram messaging service.
+
+For license and copyright information please follow this link:
+https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
+*/
+#pragma once
+
+#include <atomic>
+
+namespace MTP::details {
+
+// Passes values between threads without locking.
+//
+// Any thread can push(), any thread can takeAll() - it atomically takes
+// everything pushed so far, so consumers never see a partial list and
+// there is no single-node pop that could suffer from the ABA problem.
+template <typename Value>
+class HandoffQueue final {
+public:
+	HandoffQueue() = default;
+	HandoffQueue(const HandoffQueue &other) = delete;
+	HandoffQueue &operator=(const HandoffQueue &other) = delete;
+	~HandoffQueue() {
+		clear(_head.exchange(nullptr, std::memory_order_acquire));
+	}
+
+	// Returns true if the queue was empty before this value was pushed.
+	bool push(Value &&value) {
+		const auto node = new Node{ std::move(value) };
+		auto head = _head.load(std::memory_order_relaxed);
+		do {
+			node->next = head;
+		} while (!_head.compare_exchange_weak(
+			head,
+			node,
+			std::memory_order_release,
+			std::memory_order_relaxed));
+		return (head == nullptr);
+	}
+
+	[[nodiscard]] bool empty() const {
+		return (_head.load(std::memory_order_acquire) == nullptr);
+	}
+
+	// Values are returned in the order they were pushed.
+	[[nodiscard]] std::vector<Value> takeAll() {
+		auto node = _head.exchange(nullptr, std::memory_order_acquire);
+		auto result = std::vector<Value>();
+		for (auto i = node; i; i = i->next) {
+			result.push_back(std::move(i->value));
+		}
+		clear(node);
+		std::reverse(begin(result), end(result));
+		return result;
+	}
+
+private:
+	struct Node {
+		Value value;
+		Node *next = nullptr;
+	};
+
+	static void clear(Node *node) {
+		while (node) {
+			delete std::exchange(node, node->next);
+		}
+	}
+
+	std::atomic<Node*> _head = nullptr;
+
+};
+
+} // namespace MTP::details
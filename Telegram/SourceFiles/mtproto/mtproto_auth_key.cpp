@@ -7,6 +7,7 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 */
 #include "mtproto/mtproto_auth_key.h"
 
+#include "mtproto/details/mtproto_aes_ige.h"
 #include "base/openssl_help.h"
 
 #include <QtCore/QDataStream>
@@ -149,6 +150,10 @@ void AuthKey::countKeyId() {
 }
 
 void aesIgeEncryptRaw(const void *src, void *dst, uint32 len, const void *key, const void *iv) {
+	if (details::HardwareAesIgeSupported()) {
+		details::HardwareAesIgeEncrypt(src, dst, len, key, iv);
+		return;
+	}
 	uchar aes_key[32], aes_iv[32];
 	memcpy(aes_key, key, 32);
 	memcpy(aes_iv, iv, 32);
@@ -159,6 +164,10 @@ void aesIgeEncryptRaw(const void *src, void *dst, uint32 len, const void *key, c
 }
 
 void aesIgeDecryptRaw(const void *src, void *dst, uint32 len, const void *key, const void *iv) {
+	if (details::HardwareAesIgeSupported()) {
+		details::HardwareAesIgeDecrypt(src, dst, len, key, iv);
+		return;
+	}
 	uchar aes_key[32], aes_iv[32];
 	memcpy(aes_key, key, 32);
 	memcpy(aes_iv, iv, 32);
@@ -63,6 +63,17 @@ void SessionData::notifyConnectionInited(const SessionOptions &options) {
 	}
 }
 
+auto SessionData::toSendMap()
+-> base::flat_map<mtpRequestId, SerializedRequest> & {
+	for (auto &request : _toSendQueue.takeAll()) {
+		*(mtpMsgId*)(request->data() + 4) = 0;
+		*(request->data() + 6) = 0;
+		const auto requestId = request->requestId;
+		_toSend.emplace(requestId, std::move(request));
+	}
+	return _toSend;
+}
+
 void SessionData::queueTryToReceive() {
 	withSession([](not_null<Session*> session) {
 		session->tryToReceive();
@@ -426,12 +437,7 @@ void Session::sendPrepared(
 		crl::time msCanWait) {
 	DEBUG_LOG(("MTP Info: adding request to toSendMap, msCanWait %1"
 		).arg(msCanWait));
-	{
-		QWriteLocker locker(_data->toSendMutex());
-		_data->toSendMap().emplace(request->requestId, request);
-		*(mtpMsgId*)(request->data() + 4) = 0;
-		*(request->data() + 6) = 0;
-	}
+	_data->queueToSend(base::duplicate(request));
 
 	DEBUG_LOG(("MTP Info: added, requestId %1").arg(request->requestId));
 	if (msCanWait >= 0) {
@@ -551,9 +557,7 @@ void Session::tryToReceive() {
 		return;
 	}
 	while (true) {
-		auto lock = QWriteLocker(_data->haveReceivedMutex());
-		const auto messages = base::take(_data->haveReceivedMessages());
-		lock.unlock();
+		const auto messages = _data->takeReceivedMessages();
 		if (messages.empty()) {
 			break;
 		}
@@ -11,6 +11,7 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include "mtproto/mtproto_response.h"
 #include "mtproto/mtproto_proxy_data.h"
 #include "mtproto/details/mtproto_serialized_request.h"
+#include "mtproto/details/mtproto_handoff_queue.h"
 
 #include <QtCore/QTimer>
 
@@ -74,18 +75,27 @@ public:
 	not_null<QReadWriteLock*> haveSentMutex() {
 		return &_haveSentLock;
 	}
-	not_null<QReadWriteLock*> haveReceivedMutex() {
-		return &_haveReceivedLock;
-	}
 
-	base::flat_map<mtpRequestId, SerializedRequest> &toSendMap() {
-		return _toSend;
+	// Lock-free, applied to toSendMap() on the next access.
+	void queueToSend(SerializedRequest &&request) {
+		_toSendQueue.push(std::move(request));
 	}
+
+	// toSendMutex() should be locked for writing.
+	base::flat_map<mtpRequestId, SerializedRequest> &toSendMap();
 	base::flat_map<mtpMsgId, SerializedRequest> &haveSentMap() {
 		return _haveSent;
 	}
-	std::vector<Response> &haveReceivedMessages() {
-		return _receivedMessages;
+
+	// Lock-free, SessionPrivate -> Session.
+	void pushReceived(Response &&response) {
+		_receivedMessages.push(std::move(response));
+	}
+	[[nodiscard]] bool hasReceivedMessages() const {
+		return !_receivedMessages.empty();
+	}
+	[[nodiscard]] std::vector<Response> takeReceivedMessages() {
+		return _receivedMessages.takeAll();
 	}
 
 	// SessionPrivate -> Session interface.
@@ -120,13 +130,13 @@ private:
 	mutable QReadWriteLock _optionsLock;
 
 	base::flat_map<mtpRequestId, SerializedRequest> _toSend; // map of request_id -> request, that is waiting to be sent
+	HandoffQueue<SerializedRequest> _toSendQueue; // requests from the main thread, not yet in _toSend
 	QReadWriteLock _toSendLock;
 
 	base::flat_map<mtpMsgId, SerializedRequest> _haveSent; // map of msg_id -> request, that was sent
 	QReadWriteLock _haveSentLock;
 
-	std::vector<Response> _receivedMessages; // list of responses / updates that should be processed in the main thread
-	QReadWriteLock _haveReceivedLock;
+	HandoffQueue<Response> _receivedMessages; // list of responses / updates that should be processed in the main thread
 
 };
 
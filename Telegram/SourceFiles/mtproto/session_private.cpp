@@ -20,6 +20,7 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include "base/openssl_help.h"
 #include "base/unixtime.h"
 #include "base/platform/base_platform_info.h"
+#include "core/core_parallel.h"
 
 #include <ksandbox.h>
 #include <zlib.h>
@@ -73,6 +74,54 @@ using namespace details;
 	return idsStr + "]";
 }
 
+// Returns a view of the serialized bytes without copying them.
+[[nodiscard]] QByteArray ReadSerializedBytes(
+		const mtpPrime *from,
+		const mtpPrime *end) {
+	if (from >= end) {
+		return QByteArray();
+	}
+	const auto available = uint32(end - from) * sizeof(mtpPrime);
+	const auto data = reinterpret_cast<const uchar*>(from);
+	const auto large = (data[0] == 254);
+	if (data[0] > 254 || (large && available < 4)) {
+		return QByteArray();
+	}
+	const auto offset = large ? 4U : 1U;
+	const auto length = large
+		? (uint32(data[1]) | (uint32(data[2]) << 8) | (uint32(data[3]) << 16))
+		: uint32(data[0]);
+	if (offset + length > available) {
+		return QByteArray();
+	}
+	return QByteArray::fromRawData(
+		reinterpret_cast<const char*>(data + offset),
+		length);
+}
+
+// Gzip stores the unpacked size modulo 2^32 in its last four bytes.
+[[nodiscard]] uint32 UnpackedSizeHint(const QByteArray &packed) {
+	// Deflate can't compress better than ~1032:1.
+	constexpr auto kMaxRatio = 1032U;
+
+	if (packed.size() < 4) {
+		return 0;
+	}
+	const auto tail = reinterpret_cast<const uchar*>(packed.constData())
+		+ packed.size()
+		- 4;
+	const auto result = uint32(tail[0])
+		| (uint32(tail[1]) << 8)
+		| (uint32(tail[2]) << 16)
+		| (uint32(tail[3]) << 24);
+	return (result > 0
+		&& !(result % kIntSize)
+		&& result <= kMaxMessageLength
+		&& result <= uint64(packed.size()) * kMaxRatio)
+		? result
+		: 0;
+}
+
 [[nodiscard]] QString ComputeAppVersion() {
 #if defined Q_OS_WIN && defined Q_PROCESSOR_X86_64
 	const auto arch = u" x64"_q;
@@ -136,6 +185,76 @@ void WrapInvokeAfter(
 	return different;
 }
 
+constexpr auto kExternalHeaderIntsCount = 6U; // 2 auth_key_id, 4 msg_key
+constexpr auto kEncryptedHeaderIntsCount = 8U; // 2 salt, 2 session, 2 msg_id, 1 seq_no, 1 length
+constexpr auto kMinimalEncryptedIntsCount = kEncryptedHeaderIntsCount + 4U; // + 1 data + 3 padding
+constexpr auto kMinimalIntsCount = kExternalHeaderIntsCount + kMinimalEncryptedIntsCount;
+constexpr auto kMsgKeyShift = 8U;
+
+// Several received packets are decrypted in parallel if they're large.
+constexpr auto kParallelDecryptSize = 256 * 1024;
+
+struct ReceivedPacket {
+	mtpBuffer ints;
+	mtpBuffer decrypted;
+	bool verified = false;
+};
+
+[[nodiscard]] uint32 EncryptedIntsCount(const mtpBuffer &ints) {
+	return (uint32(ints.size()) - kExternalHeaderIntsCount) & ~0x03U;
+}
+
+void DecryptReceivedPacket(
+		ReceivedPacket &packet,
+		const AuthKeyPtr &encryptionKey) {
+	const auto ints = packet.ints.constData();
+	const auto encryptedInts = ints + kExternalHeaderIntsCount;
+	const auto encryptedBytesCount = EncryptedIntsCount(packet.ints)
+		* kIntSize;
+	const auto msgKey = *(MTPint128*)(ints + 2);
+
+	aesIgeDecrypt(encryptedInts, packet.decrypted.data(), encryptedBytesCount, encryptionKey, msgKey);
+
+	std::array<uchar, 32> sha256Buffer = { { 0 } };
+
+	SHA256_CTX msgKeyLargeContext;
+	SHA256_Init(&msgKeyLargeContext);
+	SHA256_Update(&msgKeyLargeContext, encryptionKey->partForMsgKey(false), 32);
+	SHA256_Update(&msgKeyLargeContext, packet.decrypted.constData(), encryptedBytesCount);
+	SHA256_Final(sha256Buffer.data(), &msgKeyLargeContext);
+
+	packet.verified = !ConstTimeIsDifferent(
+		&msgKey,
+		sha256Buffer.data() + kMsgKeyShift,
+		sizeof(msgKey));
+}
+
+// Packets are independent, only their handling order matters, so the
+// calling thread decrypts them together with the crl workers and waits.
+void DecryptReceivedPackets(
+		std::vector<ReceivedPacket> &packets,
+		const AuthKeyPtr &encryptionKey) {
+	auto size = 0;
+	for (const auto &packet : packets) {
+		size += packet.decrypted.size() * kIntSize;
+	}
+	const auto count = int(packets.size());
+	if (count < 2 || size < kParallelDecryptSize) {
+		for (auto &packet : packets) {
+			if (!packet.decrypted.empty()) {
+				DecryptReceivedPacket(packet, encryptionKey);
+			}
+		}
+		return;
+	}
+	Core::InvokeParallel(count, [&](int index) {
+		auto &packet = packets[index];
+		if (!packet.decrypted.empty()) {
+			DecryptReceivedPacket(packet, encryptionKey);
+		}
+	});
+}
+
 } // namespace
 
 SessionPrivate::SessionPrivate(
@@ -1238,17 +1357,32 @@ void SessionPrivate::handleReceived() {
 
 	onReceivedSome();
 
+	const auto validSize = [](const mtpBuffer &ints) {
+		const auto count = uint32(ints.size());
+		return (count >= kMinimalIntsCount)
+			&& (count <= kMaxMessageLength / kIntSize);
+	};
+	auto packets = std::vector<ReceivedPacket>();
 	while (!_connection->received().empty()) {
-		auto intsBuffer = std::move(_connection->received().front());
+		auto &packet = packets.emplace_back(ReceivedPacket{
+			.ints = std::move(_connection->received().front()),
+		});
 		_connection->received().pop_front();
+		if (validSize(packet.ints)
+			&& _keyId == *(uint64*)packet.ints.constData()) {
+			packet.decrypted = _connection->bufferPool().acquire(
+				EncryptedIntsCount(packet.ints));
+		}
+	}
+	DecryptReceivedPackets(packets, _encryptionKey);
+
+	for (auto &packet : packets) {
+		auto intsBuffer = std::move(packet.ints);
+		auto decryptedBuffer = std::move(packet.decrypted);
 
-		constexpr auto kExternalHeaderIntsCount = 6U; // 2 auth_key_id, 4 msg_key
-		constexpr auto kEncryptedHeaderIntsCount = 8U; // 2 salt, 2 session, 2 msg_id, 1 seq_no, 1 length
-		constexpr auto kMinimalEncryptedIntsCount = kEncryptedHeaderIntsCount + 4U; // + 1 data + 3 padding
-		constexpr auto kMinimalIntsCount = kExternalHeaderIntsCount + kMinimalEncryptedIntsCount;
 		auto intsCount = uint32(intsBuffer.size());
 		auto ints = intsBuffer.constData();
-		if ((intsCount < kMinimalIntsCount) || (intsCount > kMaxMessageLength / kIntSize)) {
+		if (!validSize(intsBuffer)) {
 			LOG(("TCP Error: bad message received, len %1").arg(intsCount * kIntSize));
 			return restart();
 		}
@@ -1260,15 +1394,9 @@ void SessionPrivate::handleReceived() {
 		constexpr auto kMinPaddingSize = 12U;
 		constexpr auto kMaxPaddingSize = 1024U;
 
-		auto encryptedInts = ints + kExternalHeaderIntsCount;
-		auto encryptedIntsCount = (intsCount - kExternalHeaderIntsCount) & ~0x03U;
-		auto encryptedBytesCount = encryptedIntsCount * kIntSize;
-		auto decryptedBuffer = QByteArray(encryptedBytesCount, Qt::Uninitialized);
-		auto msgKey = *(MTPint128*)(ints + 2);
+		auto encryptedBytesCount = EncryptedIntsCount(intsBuffer) * kIntSize;
 
-		aesIgeDecrypt(encryptedInts, decryptedBuffer.data(), encryptedBytesCount, _encryptionKey, msgKey);
-
-		auto decryptedInts = reinterpret_cast<const mtpPrime*>(decryptedBuffer.constData());
+		auto decryptedInts = decryptedBuffer.constData();
 		auto serverSalt = *(uint64*)&decryptedInts[0];
 		auto session = *(uint64*)&decryptedInts[2];
 		auto msgId = *(uint64*)&decryptedInts[4];
@@ -1280,16 +1408,7 @@ void SessionPrivate::handleReceived() {
 		// Can underflow, but it is an unsigned type, so we just check the range later.
 		auto paddingSize = static_cast<uint32>(encryptedBytesCount) - static_cast<uint32>(fullDataLength);
 
-		std::array<uchar, 32> sha256Buffer = { { 0 } };
-
-		SHA256_CTX msgKeyLargeContext;
-		SHA256_Init(&msgKeyLargeContext);
-		SHA256_Update(&msgKeyLargeContext, _encryptionKey->partForMsgKey(false), 32);
-		SHA256_Update(&msgKeyLargeContext, decryptedInts, encryptedBytesCount);
-		SHA256_Final(sha256Buffer.data(), &msgKeyLargeContext);
-
-		constexpr auto kMsgKeyShift = 8U;
-		if (ConstTimeIsDifferent(&msgKey, sha256Buffer.data() + kMsgKeyShift, sizeof(msgKey))) {
+		if (!packet.verified) {
 			LOG(("TCP Error: bad SHA256 hash after aesDecrypt in message"));
 			return restart();
 		}
@@ -1373,18 +1492,18 @@ void SessionPrivate::handleReceived() {
 		}
 		_receivedMessageIds.shrink();
 
+		// Message contents were copied, the buffers can be reused.
+		_connection->bufferPool().release(std::move(decryptedBuffer));
+		_connection->bufferPool().release(std::move(intsBuffer));
+
 		// send acks
 		if (const auto toAckSize = _ackRequestData.size()) {
 			DEBUG_LOG(("MTP Info: will send %1 acks, ids: %2").arg(toAckSize).arg(LogIdsVector(_ackRequestData)));
 			_sessionData->queueSendAnything(kAckSendWaiting);
 		}
 
-		auto lock = QReadLocker(_sessionData->haveReceivedMutex());
-		const auto tryToReceive = !_sessionData->haveReceivedMessages().empty();
-		lock.unlock();
-
-		if (tryToReceive) {
-			DEBUG_LOG(("MTP Info: queueTryToReceive() - need to parse in another thread, %1 messages.").arg(_sessionData->haveReceivedMessages().size()));
+		if (_sessionData->hasReceivedMessages()) {
+			DEBUG_LOG(("MTP Info: queueTryToReceive() - need to parse in another thread."));
 			_sessionData->queueTryToReceive();
 		}
 
@@ -1597,8 +1716,7 @@ SessionPrivate::HandleResult SessionPrivate::handleOneReceived(
 				)).write(reply);
 
 				// Save rpc_error for processing in the main thread.
-				QWriteLocker locker(_sessionData->haveReceivedMutex());
-				_sessionData->haveReceivedMessages().push_back({
+				_sessionData->pushReceived({
 					.reply = std::move(reply),
 					.outerMsgId = info.outerMsgId,
 					.requestId = requestId,
@@ -1825,8 +1943,7 @@ SessionPrivate::HandleResult SessionPrivate::handleOneReceived(
 		const auto requestId = wasSent(requestMsgId);
 		if (requestId && requestId != mtpRequestId(0xFFFFFFFF)) {
 			// Save rpc_result for processing in the main thread.
-			QWriteLocker locker(_sessionData->haveReceivedMutex());
-			_sessionData->haveReceivedMessages().push_back({
+			_sessionData->pushReceived({
 				.reply = std::move(response),
 				.outerMsgId = info.outerMsgId,
 				.requestId = requestId,
@@ -1878,8 +1995,7 @@ SessionPrivate::HandleResult SessionPrivate::handleOneReceived(
 		if (from > start) memcpy(update.data(), start, (from - start) * sizeof(mtpPrime));
 
 		// Notify main process about new session - need to get difference.
-		QWriteLocker locker(_sessionData->haveReceivedMutex());
-		_sessionData->haveReceivedMessages().push_back({
+		_sessionData->pushReceived({
 			.reply = update,
 			.outerMsgId = info.outerMsgId,
 		});
@@ -1928,8 +2044,7 @@ SessionPrivate::HandleResult SessionPrivate::handleOneReceived(
 		}
 
 		// Notify main process about the new updates.
-		QWriteLocker locker(_sessionData->haveReceivedMutex());
-		_sessionData->haveReceivedMessages().push_back({
+		_sessionData->pushReceived({
 			.reply = update,
 			.outerMsgId = info.outerMsgId,
 		});
@@ -1973,14 +2088,19 @@ SessionPrivate::HandleResult SessionPrivate::handleBindResponse(
 
 mtpBuffer SessionPrivate::ungzip(const mtpPrime *from, const mtpPrime *end) const {
 	mtpBuffer result; // * 4 because of mtpPrime type
-	result.resize(0);
 
-	MTPstring packed;
-	if (!packed.read(from, end)) { // read packed string as serialized mtp string type
+	// Read packed string as serialized mtp string type in place.
+	const auto packed = ReadSerializedBytes(from, end);
+	if (packed.isEmpty()) {
 		LOG(("RPC Error: could not read gziped bytes."));
 		return result;
 	}
-	uint32 packedLen = packed.v.size(), unpackedChunk = packedLen;
+	const auto started = crl::profile();
+	const auto packedLen = uint32(packed.size());
+	// Without a size hint grow by packedLen primes, 4x the packed size.
+	const auto growChunk = packedLen;
+	const auto hint = UnpackedSizeHint(packed);
+	auto allocations = 0;
 
 	z_stream stream;
 	stream.zalloc = 0;
@@ -1994,18 +2114,27 @@ mtpBuffer SessionPrivate::ungzip(const mtpPrime *from, const mtpPrime *end) cons
 		return result;
 	}
 	stream.avail_in = packedLen;
-	stream.next_in = reinterpret_cast<Bytef*>(packed.v.data());
+	stream.next_in = reinterpret_cast<Bytef*>(
+		const_cast<char*>(packed.constData()));
 
 	stream.avail_out = 0;
-	while (!stream.avail_out) {
-		result.resize(result.size() + unpackedChunk);
-		stream.avail_out = unpackedChunk * sizeof(mtpPrime);
-		stream.next_out = (Bytef*)&result[result.size() - unpackedChunk];
-		int res = inflate(&stream, Z_NO_FLUSH);
-		if (res != Z_OK && res != Z_STREAM_END) {
+	auto chunk = hint ? (hint / kIntSize) : growChunk;
+	while (res != Z_STREAM_END) {
+		if (!stream.avail_out) {
+			const auto was = result.size();
+			result.resize(was + chunk);
+			++allocations;
+			stream.avail_out = chunk * sizeof(mtpPrime);
+			stream.next_out = (Bytef*)&result[was];
+			chunk = growChunk;
+		}
+		res = inflate(&stream, Z_NO_FLUSH);
+		if (res == Z_BUF_ERROR && !stream.avail_in) {
+			break;
+		} else if (res != Z_OK && res != Z_STREAM_END) {
 			inflateEnd(&stream);
 			LOG(("RPC Error: could not unpack gziped data, code: %1").arg(res));
-			DEBUG_LOG(("RPC Error: bad gzip: %1").arg(Logs::mb(packed.v.constData(), packedLen).str()));
+			DEBUG_LOG(("RPC Error: bad gzip: %1").arg(Logs::mb(packed.constData(), packedLen).str()));
 			return mtpBuffer();
 		}
 	}
@@ -2013,6 +2142,7 @@ mtpBuffer SessionPrivate::ungzip(const mtpPrime *from, const mtpPrime *end) cons
 		uint32 badSize = result.size() * sizeof(mtpPrime) - stream.avail_out;
 		LOG(("RPC Error: bad length of unpacked data %1").arg(badSize));
 		DEBUG_LOG(("RPC Error: bad unpacked data %1").arg(Logs::mb(result.data(), badSize).str()));
+		inflateEnd(&stream);
 		return mtpBuffer();
 	}
 	result.resize(result.size() - (stream.avail_out >> 2));
@@ -2020,6 +2150,17 @@ mtpBuffer SessionPrivate::ungzip(const mtpPrime *from, const mtpPrime *end) cons
 	if (!result.size()) {
 		LOG(("RPC Error: bad length of unpacked data 0"));
 	}
+	if (Logs::DebugEnabled()) {
+		const auto unpacked = int64(result.size() * sizeof(mtpPrime));
+		const auto elapsed = crl::profile() - started;
+		DEBUG_LOG(("RPC Info: ungzipped %1 -> %2 bytes, "
+			"allocations: %3, %4 mcs (%5 mcs per MB)."
+			).arg(packedLen
+			).arg(unpacked
+			).arg(allocations
+			).arg(elapsed
+			).arg(unpacked ? (elapsed * 1024 * 1024 / unpacked) : 0));
+	}
 	return result;
 }
 
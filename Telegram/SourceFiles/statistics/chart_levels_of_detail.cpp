@@ -0,0 +1,128 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop application for the Telegram messaging service.
+
+For license and copyright information please follow this link:
+https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
+*/
+#include "statistics/chart_levels_of_detail.h"
+
+namespace Statistic {
+namespace {
+
+constexpr auto kMinPointsCount = 256;
+constexpr auto kMinBucketsCount = 16;
+
+} // namespace
+
+LevelsOfDetail::LevelsOfDetail(const std::vector<int> &y) {
+	const auto size = int(y.size());
+	if (size < kMinPointsCount) {
+		return;
+	}
+	const auto merge = [&](Bucket a, Bucket b) {
+		if (b.min >= 0 && (a.min < 0 || y[b.min] < y[a.min])) {
+			a.min = b.min;
+		}
+		if (b.max >= 0 && (a.max < 0 || y[b.max] > y[a.max])) {
+			a.max = b.max;
+		}
+		return a;
+	};
+	const auto point = [&](int i) {
+		return (i < size && y[i] >= 0) ? Bucket{ i, i } : Bucket();
+	};
+
+	auto first = std::vector<Bucket>((size + 1) / 2);
+	for (auto i = 0, till = int(first.size()); i != till; ++i) {
+		first[i] = merge(point(2 * i), point(2 * i + 1));
+	}
+	_levels.push_back(std::move(first));
+	while (_levels.back().size() > kMinBucketsCount) {
+		const auto &previous = _levels.back();
+		const auto count = int(previous.size());
+		auto level = std::vector<Bucket>((count + 1) / 2);
+		for (auto i = 0, till = int(level.size()); i != till; ++i) {
+			const auto right = 2 * i + 1;
+			level[i] = (right < count)
+				? merge(previous[2 * i], previous[right])
+				: previous[2 * i];
+		}
+		_levels.push_back(std::move(level));
+	}
+}
+
+void LevelsOfDetail::collect(
+		const std::vector<int> &y,
+		int from,
+		int to,
+		int maxCount,
+		std::vector<int> &indices) const {
+	indices.clear();
+	if (from > to) {
+		return;
+	}
+	const auto count = to - from + 1;
+	if (count <= maxCount || _levels.empty()) {
+		indices.reserve(count);
+		for (auto i = from; i <= to; ++i) {
+			indices.push_back(i);
+		}
+		return;
+	}
+
+	// Level k gives at most two points for each 2^(k + 1) ones.
+	auto k = 0;
+	while (((count >> k) > maxCount) && (k + 1 < int(_levels.size()))) {
+		++k;
+	}
+	const auto &level = _levels[k];
+	const auto shift = k + 1;
+	const auto add = [&](Bucket bucket) {
+		if (bucket.min < 0) {
+			return;
+		}
+		const auto [left, right] = std::minmax(bucket.min, bucket.max);
+		if (left > indices.back() && left < to) {
+			indices.push_back(left);
+		}
+		if (right > indices.back() && right < to) {
+			indices.push_back(right);
+		}
+	};
+
+	// Buckets crossing the range edges are scanned point by point,
+	// so that their extremes outside of the range are not used.
+	const auto scan = [&](int from, int to) {
+		auto result = Bucket();
+		for (auto i = from; i <= to; ++i) {
+			if (y[i] < 0) {
+				continue;
+			} else if (result.min < 0 || y[i] < y[result.min]) {
+				result.min = i;
+			}
+			if (result.max < 0 || y[i] > y[result.max]) {
+				result.max = i;
+			}
+		}
+		return result;
+	};
+	const auto first = (from >> shift);
+	const auto last = (to >> shift);
+	indices.reserve(2 * (last - first + 1) + 2);
+	indices.push_back(from);
+	if (first == last) {
+		add(scan(from, to));
+	} else {
+		add(scan(from, ((first + 1) << shift) - 1));
+		for (auto i = first + 1; i != last; ++i) {
+			add(level[i]);
+		}
+		add(scan(last << shift, to));
+	}
+	if (to > indices.back()) {
+		indices.push_back(to);
+	}
+}
+
+} // namespace Statistic
@@ -0,0 +1,41 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop application for the Telegram messaging service.
+
+For license and copyright information please follow this link:
+https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
+*/
+#pragma once
+
+namespace Statistic {
+
+// Min / max pyramid of a chart line: each level merges pairs of buckets
+// of the previous one. Lets painting pick a few points per pixel instead
+// of all of them, without losing peaks. Negative values are skipped.
+class LevelsOfDetail final {
+public:
+	LevelsOfDetail() = default;
+	LevelsOfDetail(const std::vector<int> &y);
+
+	// Fills ascending indices of points in [from, to] to connect,
+	// about 'maxCount' of them if the range has more points than that.
+	// The 'y' should be the same values the levels were built from.
+	void collect(
+		const std::vector<int> &y,
+		int from,
+		int to,
+		int maxCount,
+		std::vector<int> &indices) const;
+
+private:
+	struct Bucket final {
+		int min = -1;
+		int max = -1;
+	};
+
+	// _levels[k] has buckets of 2^(k + 1) points.
+	std::vector<std::vector<Bucket>> _levels;
+
+};
+
+} // namespace Statistic
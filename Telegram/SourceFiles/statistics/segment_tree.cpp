@@ -7,10 +7,50 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 */
 #include "statistics/segment_tree.h"
 
+#include <bit>
+
 namespace Statistic {
 namespace {
 
 constexpr auto kMinArraySize = size_t(30);
+constexpr auto kBlockShift = 5;
+constexpr auto kBlockSize = (1 << kBlockShift);
+
+template <typename Pick>
+[[nodiscard]] int Scan(const int *from, const int *till, int result, Pick pick) {
+	for (; from != till; ++from) {
+		result = pick(result, *from);
+	}
+	return result;
+}
+
+template <typename Pick>
+void FillLevels(
+		std::vector<std::vector<int>> &levels,
+		const std::vector<int> &array,
+		Pick pick) {
+	const auto size = int(array.size());
+	const auto blocks = (size + kBlockSize - 1) >> kBlockShift;
+	const auto count = int(std::bit_width(unsigned(blocks)));
+	levels.resize(count);
+
+	auto &first = levels.front();
+	first.resize(blocks);
+	for (auto i = 0; i != blocks; ++i) {
+		const auto from = array.data() + (i << kBlockShift);
+		const auto till = array.data() + std::min(size, (i + 1) << kBlockShift);
+		first[i] = Scan(from + 1, till, *from, pick);
+	}
+	for (auto k = 1; k != count; ++k) {
+		const auto &previous = levels[k - 1];
+		const auto half = (1 << (k - 1));
+		auto &level = levels[k];
+		level.resize(blocks - (1 << k) + 1);
+		for (auto i = 0, till = int(level.size()); i != till; ++i) {
+			level[i] = pick(previous[i], previous[i + half]);
+		}
+	}
+}
 
 } // namespace
 
@@ -19,36 +59,44 @@ SegmentTree::SegmentTree(std::vector<int> array)
 	if (_array.size() < kMinArraySize) {
 		return;
 	}
-
-	// The max size of this array is about 2 * 2 ^ log2(n) + 1.
-	const auto size = 2 * std::pow(
-		2.,
-		std::floor((std::log(_array.size()) / std::log(2.)) + 1));
-	_heap.resize(int(size));
-	build(1, 0, _array.size());
+	FillLevels(_max, _array, [](int a, int b) { return std::max(a, b); });
+	FillLevels(_min, _array, [](int a, int b) { return std::min(a, b); });
 }
 
-void SegmentTree::build(int v, int from, int size) {
-	_heap[v].from = from;
-	_heap[v].to = (from + size - 1);
-
-	if (size == 1) {
-		_heap[v].sum = _array[from];
-		_heap[v].max = _array[from];
-		_heap[v].min = _array[from];
-	} else {
-		// Build children.
-		build(2 * v, from, size / 2);
-		build(2 * v + 1, from + size / 2, size - size / 2);
-
-		_heap[v].sum = _heap[2 * v].sum + _heap[2 * v + 1].sum;
-		// max = max of the children.
-		_heap[v].max = std::max(_heap[2 * v].max, _heap[2 * v + 1].max);
-		_heap[v].min = std::min(_heap[2 * v].min, _heap[2 * v + 1].min);
+template <typename Pick>
+int SegmentTree::query(
+		const Levels &levels,
+		int from,
+		int to,
+		int empty,
+		Pick pick) const {
+	from = std::max(from, 0);
+	to = std::min(to, int(_array.size() - 1));
+	if (from > to) {
+		return empty;
+	}
+	const auto data = _array.data();
+	const auto fromBlock = from >> kBlockShift;
+	const auto toBlock = to >> kBlockShift;
+	if (fromBlock == toBlock) {
+		return Scan(data + from + 1, data + to + 1, data[from], pick);
+	}
+	auto result = Scan(
+		data + from + 1,
+		data + ((fromBlock + 1) << kBlockShift),
+		data[from],
+		pick);
+	result = Scan(data + (toBlock << kBlockShift), data + to + 1, result, pick);
+	if (const auto count = toBlock - fromBlock - 1) {
+		const auto k = int(std::bit_width(unsigned(count))) - 1;
+		const auto &level = levels[k];
+		result = pick(result, level[fromBlock + 1]);
+		result = pick(result, level[toBlock - (1 << k)]);
 	}
+	return result;
 }
 
-int SegmentTree::rMaxQ(int from, int to) {
+int SegmentTree::rMaxQ(int from, int to) const {
 	if (_array.size() < kMinArraySize) {
 		auto max = 0;
 		from = std::max(from, 0);
@@ -58,33 +106,12 @@ int SegmentTree::rMaxQ(int from, int to) {
 		}
 		return max;
 	}
-	return rMaxQ(1, from, to);
-}
-
-int SegmentTree::rMaxQ(int v, int from, int to) {
-	const auto &n = _heap[v];
-	// If you did a range update that contained this node,
-	// you can infer the Min value without going down the tree.
-	if (n.pendingVal && contains(n.from, n.to, from, to)) {
-		return n.pendingVal.value;
-	}
-
-	if (contains(from, to, n.from, n.to)) {
-		return _heap[v].max;
-	}
-
-	if (intersects(from, to, n.from, n.to)) {
-		propagate(v);
-		const auto leftMin = rMaxQ(2 * v, from, to);
-		const auto rightMin = rMaxQ(2 * v + 1, from, to);
-
-		return std::max(leftMin, rightMin);
-	}
-
-	return 0;
+	return query(_max, from, to, 0, [](int a, int b) {
+		return std::max(a, b);
+	});
 }
 
-int SegmentTree::rMinQ(int from, int to) {
+int SegmentTree::rMinQ(int from, int to) const {
 	if (_array.size() < kMinArraySize) {
 		auto min = std::numeric_limits<int>::max();
 		from = std::max(from, 0);
@@ -94,58 +121,10 @@ int SegmentTree::rMinQ(int from, int to) {
 		}
 		return min;
 	}
-	return rMinQ(1, from, to);
-}
-
-int SegmentTree::rMinQ(int v, int from, int to) {
-	const auto &n = _heap[v];
-	// If you did a range update that contained this node,
-	// you can infer the Min value without going down the tree.
-	if (n.pendingVal && contains(n.from, n.to, from, to)) {
-		return n.pendingVal.value;
-	}
-
-	if (contains(from, to, n.from, n.to)) {
-		return _heap[v].min;
-	}
-
-	if (intersects(from, to, n.from, n.to)) {
-		propagate(v);
-		const auto leftMin = rMinQ(2 * v, from, to);
-		const auto rightMin = rMinQ(2 * v + 1, from, to);
-
-		return std::min(leftMin, rightMin);
-	}
-
-	return std::numeric_limits<int>::max();
-}
-
-void SegmentTree::propagate(int v) {
-	auto &n = _heap[v];
-
-	if (n.pendingVal) {
-		const auto value = n.pendingVal.value;
-		n.pendingVal = {};
-		change(_heap[2 * v], value);
-		change(_heap[2 * v + 1], value);
-	}
-}
-
-void SegmentTree::change(SegmentTree::Node &n, int value) {
-	n.pendingVal = { value, true };
-	n.sum = n.size() * value;
-	n.max = value;
-	n.min = value;
-	_array[n.from] = value;
-}
-
-bool SegmentTree::contains(int from1, int to1, int from2, int to2) const {
-	return (from2 >= from1) && (to2 <= to1);
-}
-
-bool SegmentTree::intersects(int from1, int to1, int from2, int to2) const {
-	return ((from1 <= from2) && (to1 >= from2)) // (.[..)..] or (.[...]..)
-		|| ((from1 >= from2) && (from1 <= to2)); // [.(..]..) or [..(..)..
+	const auto empty = std::numeric_limits<int>::max();
+	return query(_min, from, to, empty, [](int a, int b) {
+		return std::min(a, b);
+	});
 }
 
 } // namespace Statistic
@@ -9,6 +9,10 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 
 namespace Statistic {
 
+// Answers range min / max queries in O(1) plus a scan of at most two
+// blocks: per block extremes are kept in a sparse table, while partial
+// blocks at the edges of the range are scanned directly, which compilers
+// vectorize well. The values are immutable after construction.
 class SegmentTree final {
 public:
 	SegmentTree() = default;
@@ -21,48 +25,24 @@ public:
 		return !empty();
 	}
 
-	[[nodiscard]] int rMaxQ(int from, int to);
-	[[nodiscard]] int rMinQ(int from, int to);
+	[[nodiscard]] int rMaxQ(int from, int to) const;
+	[[nodiscard]] int rMinQ(int from, int to) const;
 
 private:
-	struct Node final {
-		int sum = 0;
-		int max = 0;
-		int min = 0;
+	// _levels[k][i] is the extreme of blocks [i, i + 2^k).
+	using Levels = std::vector<std::vector<int>>;
 
-		struct PendingVal {
-			[[nodiscard]] explicit operator bool() const {
-				return available;
-			}
-			int value = 0;
-			bool available = false;
-		};
-		PendingVal pendingVal;
-
-		int from = 0;
-		int to = 0;
-
-		[[nodiscard]] int size() {
-			return to - from + 1;
-		}
-	};
-
-	void build(int v, int from, int size);
-	void propagate(int v);
-	void change(Node &n, int value);
-
-	[[nodiscard]] int rMaxQ(int v, int from, int to);
-	[[nodiscard]] int rMinQ(int v, int from, int to);
-
-	[[nodiscard]] bool contains(int from1, int to1, int from2, int to2) const;
-	[[nodiscard]] bool intersects(
-		int from1,
-		int to1,
-		int from2,
-		int to2) const;
+	template <typename Pick>
+	[[nodiscard]] int query(
+		const Levels &levels,
+		int from,
+		int to,
+		int empty,
+		Pick pick) const;
 
 	std::vector<int> _array;
-	std::vector<Node> _heap;
+	Levels _max;
+	Levels _min;
 
 };
 
@@ -18,6 +18,8 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 namespace Statistic {
 namespace {
 
+constexpr auto kPointsPerPixel = 2;
+
 void PaintChartLine(
 		QPainter &p,
 		int lineIndex,
@@ -35,7 +37,15 @@ void PaintChartLine(
 
 	const auto ratio = ratios.ratio(line.id);
 
-	for (auto i = localStart; i <= localEnd; i++) {
+	auto indices = std::vector<int>();
+	line.levelsOfDetail.collect(
+		line.y,
+		localStart,
+		localEnd,
+		c.rect.width() * style::DevicePixelRatio() * kPointsPerPixel,
+		indices);
+	chartPoints.reserve(indices.size());
+	for (const auto i : indices) {
 		if (line.y[i] < 0) {
 			continue;
 		}
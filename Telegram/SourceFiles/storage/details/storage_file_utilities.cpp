@@ -25,13 +25,6 @@ constexpr auto TdfMagicLen = int(sizeof(TdfMagic));
 
 constexpr auto kStrongIterationsCount = 100'000;
 
-struct WriteEntry {
-	QString basePath;
-	QString base;
-	QByteArray data;
-	QByteArray md5;
-};
-
 class WriteManager final {
 public:
 	explicit WriteManager(crl::weak_on_thread<WriteManager> weak);
@@ -424,10 +417,8 @@ void FileWriteDescriptor::writeEncrypted(
 	writeData(PrepareEncrypted(data, key));
 }
 
-void FileWriteDescriptor::finish() {
-	if (!_stream.device()) {
-		return;
-	}
+WriteEntry FileWriteDescriptor::prepare() {
+	Expects(_stream.device() != nullptr);
 
 	_stream.setDevice(nullptr);
 	_md5.feed(&_fullSize, sizeof(_fullSize));
@@ -437,12 +428,19 @@ void FileWriteDescriptor::finish() {
 
 	_buffer.close();
 
-	auto entry = WriteEntry{
+	return {
 		.basePath = _basePath,
 		.base = _base,
 		.data = _safeData,
 		.md5 = QByteArray((const char*)_md5.result(), 0x10)
 	};
+}
+
+void FileWriteDescriptor::finish() {
+	if (!_stream.device()) {
+		return;
+	}
+	auto entry = prepare();
 	if (_sync) {
 		Manager.writeSync(std::move(entry));
 	} else {
@@ -665,6 +663,10 @@ bool ReadEncryptedFile(
 	return ReadEncryptedFile(result, ToFilePart(fkey), basePath, key);
 }
 
+void WriteFile(WriteEntry &&entry) {
+	Manager.write(std::move(entry));
+}
+
 void Sync() {
 	Manager.sync();
 }
@@ -52,6 +52,13 @@ struct EncryptedDescriptor final {
 	EncryptedDescriptor &data,
 	const MTP::AuthKeyPtr &key);
 
+struct WriteEntry {
+	QString basePath;
+	QString base;
+	QByteArray data;
+	QByteArray md5;
+};
+
 class FileWriteDescriptor final {
 public:
 	FileWriteDescriptor(
@@ -69,6 +76,10 @@ public:
 		EncryptedDescriptor &data,
 		const MTP::AuthKeyPtr &key);
 
+	// Builds the file contents without writing them, may be called on any
+	// thread. The result should be passed to WriteFile on the main thread.
+	[[nodiscard]] WriteEntry prepare();
+
 private:
 	void init(const QString &name);
 	void finish();
@@ -106,6 +117,8 @@ bool ReadEncryptedFile(
 	const QString &basePath,
 	const MTP::AuthKeyPtr &key);
 
+void WriteFile(WriteEntry &&entry);
+
 void Sync();
 void Finish();
 
@@ -32,6 +32,16 @@ constexpr auto kMaxTrackedSuccesses = kRetryAddSessionSuccesses
 constexpr auto kRemoveSessionAfterTimeouts = 4;
 constexpr auto kResetDownloadPrioritiesTimeout = crl::time(200);
 constexpr auto kBadRequestDurationThreshold = 8 * crl::time(1000);
+constexpr auto kDurationSmoothFactor = 8;
+
+// We aim to keep requests waiting in a session not longer than
+// kTargetQueueingFactor times the fastest request duration we've seen.
+// While the smoothed duration stays below that the amount of waited
+// bytes grows, when it exceeds kShrinkQueueingFactor times the fastest
+// one the amount shrinks, and in between it settles near
+// the bandwidth-delay product.
+constexpr auto kTargetQueueingFactor = 2;
+constexpr auto kShrinkQueueingFactor = 3;
 
 // Each (session remove by timeouts) we wait for time:
 // kRetryAddSessionTimeout * max(removesCount, kMaxTrackedSessionRemoves)
@@ -242,11 +252,14 @@ void DownloadManagerMtproto::requestSucceeded(
 		|| (amountAtRequestStart > data.maxWaitedAmount);
 	const auto parts = amountAtRequestStart / kDownloadPartSize;
 	const auto duration = (crl::now() - timeAtRequestStart);
-	DEBUG_LOG(("Download (%1,%2) request done, duration: %3, parts: %4%5"
+	DEBUG_LOG(("Download (%1,%2) request done, duration: %3, parts: %4, "
+		"speed: %5 KB/s%6"
 		).arg(dcId
 		).arg(index
 		).arg(duration
 		).arg(parts
+		).arg(amountAtRequestStart * crl::time(1000)
+			/ (std::max(duration, crl::time(1)) * 1024)
 		).arg(overloaded ? " (overloaded)" : ""));
 	if (overloaded) {
 		return;
@@ -259,7 +272,19 @@ void DownloadManagerMtproto::requestSucceeded(
 		});
 		return;
 	}
+	const auto measured = std::max(duration, crl::time(1));
+	data.minDuration = data.minDuration
+		? std::min(data.minDuration, measured)
+		: measured;
+	data.smoothedDuration = data.smoothedDuration
+		? ((data.smoothedDuration * (kDurationSmoothFactor - 1) + measured)
+			/ kDurationSmoothFactor)
+		: measured;
+	const auto queueing = [&](int factor) {
+		return data.smoothedDuration > data.minDuration * factor;
+	};
 	if (amountAtRequestStart == data.maxWaitedAmount
+		&& !queueing(kTargetQueueingFactor)
 		&& data.maxWaitedAmount < kMaxWaitedInSession) {
 		data.maxWaitedAmount = std::min(
 			data.maxWaitedAmount + kDownloadPartSize,
@@ -268,6 +293,15 @@ void DownloadManagerMtproto::requestSucceeded(
 			).arg(dcId
 			).arg(index
 			).arg(data.maxWaitedAmount));
+	} else if (queueing(kShrinkQueueingFactor)
+		&& data.maxWaitedAmount > kStartWaitedInSession) {
+		data.maxWaitedAmount = std::max(
+			data.maxWaitedAmount - kDownloadPartSize,
+			kStartWaitedInSession);
+		DEBUG_LOG(("Download (%1,%2) decreased max waited amount %3."
+			).arg(dcId
+			).arg(index
+			).arg(data.maxWaitedAmount));
 	}
 	data.successes = std::min(data.successes + 1, kMaxTrackedSuccesses);
 	const auto notEnough = ranges::any_of(
@@ -322,6 +356,13 @@ void DownloadManagerMtproto::sessionTimedOut(MTP::DcId dcId, int index) {
 	for (auto &session : dc.sessions) {
 		session.successes = 0;
 	}
+	auto &timedOut = dc.sessions[index];
+	timedOut.minDuration = timedOut.smoothedDuration = 0;
+	// Keep a whole number of parts, only those are ever requested.
+	timedOut.maxWaitedAmount = std::max(
+		(timedOut.maxWaitedAmount / (2 * kDownloadPartSize))
+			* kDownloadPartSize,
+		kStartWaitedInSession);
 	if (dc.sessions.size() == kStartSessionsCount
 		|| ++dc.timeouts < kRemoveSessionAfterTimeouts) {
 		return;
@@ -81,6 +81,8 @@ private:
 		int requested = 0;
 		int successes = 0; // Since last timeout in this dc in any session.
 		int maxWaitedAmount = 0;
+		crl::time minDuration = 0; // Since last timeout in this session.
+		crl::time smoothedDuration = 0;
 	};
 	struct DcBalanceData {
 		DcBalanceData();
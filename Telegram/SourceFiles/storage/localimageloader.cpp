@@ -214,6 +214,11 @@ struct PreparedFileThumbnail {
 	return PhotoSideLimit(SendLargePhotosAtomic.load());
 }
 
+// Reads the global last dialog path, so it is called on the main thread.
+[[nodiscard]] QString VoiceFilename() {
+	return filedialogDefaultName(u"audio"_q, u".ogg"_q, QString(), true);
+}
+
 } // namespace
 
 const char kOptionSendLargePhotos[] = "send-large-photos";
@@ -258,7 +263,8 @@ SendMediaReady::SendMediaReady(
 	}
 }
 
-TaskQueue::TaskQueue(crl::time stopTimeoutMs) {
+TaskQueue::TaskQueue(crl::time stopTimeoutMs, int threadsCount)
+: _threadsCount(std::max(threadsCount, 1)) {
 	if (stopTimeoutMs > 0) {
 		_stopTimer = new QTimer(this);
 		connect(_stopTimer, SIGNAL(timeout()), this, SLOT(stop()));
@@ -271,10 +277,14 @@ TaskId TaskQueue::addTask(std::unique_ptr<Task> &&task) {
 	const auto result = task->id();
 	{
 		QMutexLocker lock(&_tasksToProcessMutex);
-		_tasksToProcess.push_back(std::move(task));
+		_tasksToProcess.push_back({
+			.task = std::move(task),
+			.index = _taskIndex++,
+			.queued = crl::now(),
+		});
 	}
 
-	wakeThread();
+	wakeThreads();
 
 	return result;
 }
@@ -282,49 +292,94 @@ TaskId TaskQueue::addTask(std::unique_ptr<Task> &&task) {
 void TaskQueue::addTasks(std::vector<std::unique_ptr<Task>> &&tasks) {
 	{
 		QMutexLocker lock(&_tasksToProcessMutex);
+		const auto now = crl::now();
 		for (auto &task : tasks) {
-			_tasksToProcess.push_back(std::move(task));
+			_tasksToProcess.push_back({
+				.task = std::move(task),
+				.index = _taskIndex++,
+				.queued = now,
+			});
 		}
 	}
 
-	wakeThread();
+	wakeThreads();
 }
 
-void TaskQueue::wakeThread() {
-	if (!_thread) {
-		_thread = new QThread();
+void TaskQueue::wakeThreads() {
+	if (_threads.empty()) {
+		_threads.reserve(_threadsCount);
+		_workers.reserve(_threadsCount);
+		for (auto i = 0; i != _threadsCount; ++i) {
+			const auto thread = _threads.emplace_back(new QThread());
 
-		_worker = new TaskQueueWorker(this);
-		_worker->moveToThread(_thread);
+			const auto worker = _workers.emplace_back(
+				new TaskQueueWorker(this));
+			worker->moveToThread(thread);
 
-		connect(this, SIGNAL(taskAdded()), _worker, SLOT(onTaskAdded()));
-		connect(_worker, SIGNAL(taskProcessed()), this, SLOT(onTaskProcessed()));
+			connect(this, SIGNAL(taskAdded()), worker, SLOT(onTaskAdded()));
+			connect(worker, SIGNAL(taskProcessed()), this, SLOT(onTaskProcessed()));
 
-		_thread->start();
+			thread->start();
+		}
 	}
 	if (_stopTimer) _stopTimer->stop();
 	taskAdded();
 }
 
-void TaskQueue::cancelTask(TaskId id) {
-	const auto removeFrom = [&](std::deque<std::unique_ptr<Task>> &queue) {
-		const auto proj = [](const std::unique_ptr<Task> &task) {
-			return task->id();
-		};
-		auto i = ranges::find(queue, id, proj);
-		if (i != queue.end()) {
-			queue.erase(i);
+bool TaskQueue::enqueueProcessed(
+		uint64 index,
+		std::unique_ptr<Task> task) {
+	const auto wasEmpty = _tasksToFinish.empty();
+	_tasksProcessed.emplace(index, std::move(task));
+	auto i = _tasksProcessed.begin();
+	while (i != _tasksProcessed.end() && i->first == _finishIndex) {
+		if (i->second) {
+			_tasksToFinish.push_back(std::move(i->second));
 		}
+		i = _tasksProcessed.erase(i);
+		++_finishIndex;
+	}
+	return wasEmpty && !_tasksToFinish.empty();
+}
+
+void TaskQueue::cancelTask(TaskId id) {
+	const auto proj = [](const std::unique_ptr<Task> &task) {
+		return task ? task->id() : TaskId();
 	};
+	auto notify = false;
 	{
 		QMutexLocker lock(&_tasksToProcessMutex);
-		removeFrom(_tasksToProcess);
-		if (_taskInProcessId == id) {
-			_taskInProcessId = TaskId();
+		const auto i = ranges::find(
+			_tasksToProcess,
+			id,
+			[&](const QueuedTask &queued) { return proj(queued.task); });
+		if (i != _tasksToProcess.end()) {
+			const auto index = i->index;
+			_tasksToProcess.erase(i);
+
+			// Keep the finish() order of the following tasks.
+			QMutexLocker lockToFinish(&_tasksToFinishMutex);
+			notify = enqueueProcessed(index, nullptr);
 		}
+		_tasksInProcess.remove(id);
+	}
+	{
+		QMutexLocker lock(&_tasksToFinishMutex);
+		for (auto &[index, task] : _tasksProcessed) {
+			if (proj(task) == id) {
+				task = nullptr;
+			}
+		}
+		const auto i = ranges::find(_tasksToFinish, id, proj);
+		if (i != _tasksToFinish.end()) {
+			_tasksToFinish.erase(i);
+		}
+	}
+	if (notify) {
+		crl::on_main(this, [=] {
+			onTaskProcessed();
+		});
 	}
-	QMutexLocker lock(&_tasksToFinishMutex);
-	removeFrom(_tasksToFinish);
 }
 
 void TaskQueue::onTaskProcessed() {
@@ -341,24 +396,34 @@ void TaskQueue::onTaskProcessed() {
 
 	if (_stopTimer) {
 		QMutexLocker lock(&_tasksToProcessMutex);
-		if (_tasksToProcess.empty() && !_taskInProcessId) {
+		if (_tasksToProcess.empty() && _tasksInProcess.empty()) {
 			_stopTimer->start();
 		}
 	}
 }
 
 void TaskQueue::stop() {
-	if (_thread) {
-		_thread->requestInterruption();
-		_thread->quit();
+	if (!_threads.empty()) {
+		for (const auto thread : _threads) {
+			thread->requestInterruption();
+			thread->quit();
+		}
 		DEBUG_LOG(("Waiting for taskThread to finish"));
-		_thread->wait();
-		delete base::take(_worker);
-		delete base::take(_thread);
+		for (const auto thread : _threads) {
+			thread->wait();
+		}
+		for (const auto worker : base::take(_workers)) {
+			delete worker;
+		}
+		for (const auto thread : base::take(_threads)) {
+			delete thread;
+		}
 	}
 	_tasksToProcess.clear();
+	_tasksProcessed.clear();
 	_tasksToFinish.clear();
-	_taskInProcessId = TaskId();
+	_tasksInProcess.clear();
+	_taskIndex = _finishIndex = 0;
 }
 
 TaskQueue::~TaskQueue() {
@@ -372,29 +437,36 @@ void TaskQueueWorker::onTaskAdded() {
 
 	bool someTasksLeft = false;
 	do {
-		auto task = std::unique_ptr<Task>();
+		auto queued = TaskQueue::QueuedTask();
 		{
 			QMutexLocker lock(&_queue->_tasksToProcessMutex);
 			if (!_queue->_tasksToProcess.empty()) {
-				task = std::move(_queue->_tasksToProcess.front());
+				queued = std::move(_queue->_tasksToProcess.front());
 				_queue->_tasksToProcess.pop_front();
-				_queue->_taskInProcessId = task->id();
+				_queue->_tasksInProcess.emplace(queued.task->id());
 			}
 		}
 
-		if (task) {
-			task->process();
+		if (queued.task) {
+			const auto started = crl::now();
+			queued.task->process();
+			DEBUG_LOG(("Task Info: processed in %1 ms, waited %2 ms."
+				).arg(crl::now() - started
+				).arg(started - queued.queued));
+
 			bool emitTaskProcessed = false;
 			{
 				QMutexLocker lockToProcess(&_queue->_tasksToProcessMutex);
-				if (_queue->_taskInProcessId == task->id()) {
-					_queue->_taskInProcessId = TaskId();
-					someTasksLeft = !_queue->_tasksToProcess.empty();
-
-					QMutexLocker lockToFinish(&_queue->_tasksToFinishMutex);
-					emitTaskProcessed = _queue->_tasksToFinish.empty();
-					_queue->_tasksToFinish.push_back(std::move(task));
+				if (!_queue->_tasksInProcess.remove(queued.task->id())) {
+					// Task was canceled while being processed.
+					queued.task = nullptr;
 				}
+				someTasksLeft = !_queue->_tasksToProcess.empty();
+
+				QMutexLocker lockToFinish(&_queue->_tasksToFinishMutex);
+				emitTaskProcessed = _queue->enqueueProcessed(
+					queued.index,
+					std::move(queued.task));
 			}
 			if (emitTaskProcessed) {
 				taskProcessed();
@@ -515,7 +587,10 @@ FileLoadTask::FileLoadTask(
 , _information(std::move(information))
 , _type(type)
 , _caption(caption)
-, _spoiler(spoiler) {
+, _spoiler(spoiler)
+, _voiceFilename((type == SendMediaType::Audio)
+	? VoiceFilename()
+	: QString()) {
 	Expects(to.options.scheduled
 		|| !to.replaceMediaOf
 		|| IsServerMsgId(to.replaceMediaOf));
@@ -538,7 +613,8 @@ FileLoadTask::FileLoadTask(
 , _duration(duration)
 , _waveform(waveform)
 , _type(SendMediaType::Audio)
-, _caption(caption) {
+, _caption(caption)
+, _voiceFilename(VoiceFilename()) {
 }
 
 FileLoadTask::~FileLoadTask() = default;
@@ -763,7 +839,7 @@ void FileLoadTask::process(Args &&args) {
 	} else if (!_content.isEmpty()) {
 		filesize = _content.size();
 		if (isVoice) {
-			filename = filedialogDefaultName(u"audio"_q, u".ogg"_q, QString(), true);
+			filename = _voiceFilename;
 			filemime = "audio/ogg";
 		} else {
 			if (_information) {
@@ -91,7 +91,10 @@ class TaskQueue : public QObject {
 	Q_OBJECT
 
 public:
-	explicit TaskQueue(crl::time stopTimeoutMs = 0); // <= 0 - never stop worker
+	// stopTimeoutMs <= 0 - never stop workers.
+	// Tasks are processed in up to threadsCount threads at once,
+	// but their finish() is always called in the order they were added.
+	explicit TaskQueue(crl::time stopTimeoutMs = 0, int threadsCount = 1);
 
 	TaskId addTask(std::unique_ptr<Task> &&task);
 	void addTasks(std::vector<std::unique_ptr<Task>> &&tasks);
@@ -109,14 +112,28 @@ public Q_SLOTS:
 private:
 	friend class TaskQueueWorker;
 
-	void wakeThread();
+	struct QueuedTask {
+		std::unique_ptr<Task> task;
+		uint64 index = 0;
+		crl::time queued = 0;
+	};
+
+	void wakeThreads();
+
+	// Expects _tasksToFinishMutex to be locked.
+	// Returns true if onTaskProcessed() should be called.
+	bool enqueueProcessed(uint64 index, std::unique_ptr<Task> task);
 
-	std::deque<std::unique_ptr<Task>> _tasksToProcess;
+	const int _threadsCount = 1;
+	std::deque<QueuedTask> _tasksToProcess;
+	base::flat_map<uint64, std::unique_ptr<Task>> _tasksProcessed;
 	std::deque<std::unique_ptr<Task>> _tasksToFinish;
-	TaskId _taskInProcessId = TaskId();
+	base::flat_set<TaskId> _tasksInProcess;
+	uint64 _taskIndex = 0;
+	uint64 _finishIndex = 0;
 	QMutex _tasksToProcessMutex, _tasksToFinishMutex;
-	QThread *_thread = nullptr;
-	TaskQueueWorker *_worker = nullptr;
+	std::vector<QThread*> _threads;
+	std::vector<TaskQueueWorker*> _workers;
 	QTimer *_stopTimer = nullptr;
 
 };
@@ -311,6 +328,7 @@ private:
 	SendMediaType _type;
 	TextWithTags _caption;
 	bool _spoiler = false;
+	QString _voiceFilename;
 
 	std::shared_ptr<FileLoadResult> _result;
 
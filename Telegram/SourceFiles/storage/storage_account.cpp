@@ -61,6 +61,9 @@ constexpr auto kMultiDraftCursorsTagOld = quint64(0xFFFF'FFFF'FFFF'FF02ULL);
 constexpr auto kMultiDraftTag = quint64(0xFFFF'FFFF'FFFF'FF03ULL);
 constexpr auto kMultiDraftCursorsTag = quint64(0xFFFF'FFFF'FFFF'FF04ULL);
 constexpr auto kRichDraftsTag = quint64(0xFFFF'FFFF'FFFF'FF05ULL);
+constexpr auto kHistoryCacheTag = quint64(0xFFFF'FFFF'FFFF'FF06ULL);
+constexpr auto kMaxHistoryCacheCount = 512;
+constexpr auto kMaxHistoryCacheSize = 4 * 1024 * 1024;
 
 enum { // Local Storage Keys
 	lskUserMap = 0x00,
@@ -87,6 +90,7 @@ enum { // Local Storage Keys
 	lskSelfSerialized = 0x15, // serialized self
 	lskMasksKeys = 0x16, // no data
 	lskCustomEmojiKeys = 0x17, // no data
+	lskHistoryCache = 0x18, // data: PeerId peer
 };
 
 auto EmptyMessageDraftSources()
@@ -123,6 +127,112 @@ auto EmptyMessageDraftSources()
 	return cWorkingDir() + u"tdata/tdld/"_q;
 }
 
+[[nodiscard]] bool HasTimeToLive(const MTPMessage &message) {
+	return message.match([](const MTPDmessage &data) {
+		if (const auto period = data.vttl_period(); period && period->v > 0) {
+			return true;
+		} else if (const auto media = data.vmedia()) {
+			return media->match([](const MTPDmessageMediaPhoto &data) {
+				return data.vttl_seconds() ? true : false;
+			}, [](const MTPDmessageMediaDocument &data) {
+				return data.vttl_seconds() ? true : false;
+			}, [](const auto &) {
+				return false;
+			});
+		}
+		return false;
+	}, [](const MTPDmessageService &data) {
+		const auto period = data.vttl_period();
+		return (period && period->v > 0);
+	}, [](const MTPDmessageEmpty &) {
+		return false;
+	});
+}
+
+// Self-destructing messages are never kept in the history cache.
+[[nodiscard]] MTPmessages_Messages FilterHistoryCache(
+		const MTPmessages_Messages &slice,
+		const base::flat_set<MsgId> &deleted) {
+	return slice.match([](const MTPDmessages_messagesNotModified &) {
+		return MTP_messages_messages(
+			MTP_vector<MTPMessage>(),
+			MTP_vector<MTPChat>(),
+			MTP_vector<MTPUser>());
+	}, [&](const auto &data) {
+		auto messages = QVector<MTPMessage>();
+		messages.reserve(data.vmessages().v.size());
+		for (const auto &message : data.vmessages().v) {
+			if (!HasTimeToLive(message)
+				&& !deleted.contains(IdFromMessage(message))) {
+				messages.push_back(message);
+			}
+		}
+		return MTP_messages_messages(
+			MTP_vector<MTPMessage>(std::move(messages)),
+			data.vchats(),
+			data.vusers());
+	});
+}
+
+// Returns an empty array if there is nothing to keep.
+[[nodiscard]] QByteArray PrepareHistoryCache(
+		PeerId peerId,
+		const MTPmessages_Messages &slice,
+		const MTP::AuthKeyPtr &localKey) {
+	const auto &messages = slice.c_messages_messages().vmessages().v;
+	if (messages.isEmpty()) {
+		return QByteArray();
+	}
+	auto serialized = mtpBuffer();
+	serialized.reserve(slice.innerLength() >> 2);
+	slice.write(serialized);
+	const auto bytes = int(serialized.size() * sizeof(mtpPrime));
+	if (bytes > kMaxHistoryCacheSize) {
+		return QByteArray();
+	}
+
+	auto size = int(sizeof(quint64) * 2 + sizeof(quint32) + bytes);
+	EncryptedDescriptor data(size);
+	data.stream
+		<< quint64(kHistoryCacheTag)
+		<< SerializePeerId(peerId)
+		<< QByteArray::fromRawData(
+			reinterpret_cast<const char*>(serialized.constData()),
+			bytes);
+	return PrepareEncrypted(data, localKey);
+}
+
+[[nodiscard]] std::optional<MTPmessages_Messages> ReadHistoryCacheFile(
+		PeerId peerId,
+		FileKey key,
+		const QString &basePath,
+		const MTP::AuthKeyPtr &localKey) {
+	FileReadDescriptor cache;
+	if (!ReadEncryptedFile(cache, key, basePath, localKey)) {
+		return std::nullopt;
+	}
+
+	quint64 tag = 0;
+	quint64 cachePeerSerialized = 0;
+	QByteArray serialized;
+	cache.stream >> tag >> cachePeerSerialized >> serialized;
+	const auto cachePeer = DeserializePeerId(cachePeerSerialized);
+	if (!CheckStreamStatus(cache.stream)
+		|| tag != kHistoryCacheTag
+		|| cachePeer != peerId
+		|| serialized.isEmpty()
+		|| (serialized.size() % sizeof(mtpPrime)) != 0) {
+		return std::nullopt;
+	}
+	auto from = reinterpret_cast<const mtpPrime*>(serialized.constData());
+	const auto end = from + (serialized.size() / sizeof(mtpPrime));
+	auto result = MTPmessages_Messages();
+	if (!result.read(from, end) || from != end) {
+		return std::nullopt;
+	}
+	return result;
+}
+
 } // namespace
 
 Account::Account(not_null<Main::Account*> owner, const QString &dataName)
@@ -137,7 +247,8 @@ Account::Account(not_null<Main::Account*> owner, const QString &dataName)
 , _cacheTotalTimeLimit(Database::Settings().totalTimeLimit)
 , _cacheBigFileTotalTimeLimit(Database::Settings().totalTimeLimit)
 , _writeMapTimer([=] { writeMap(); })
-, _writeLocationsTimer([=] { writeLocations(); }) {
+, _writeLocationsTimer([=] { writeLocations(); })
+, _writeHistoryCacheTimer([=] { writeHistoryCaches(); }) {
 }
 
 Account::~Account() {
@@ -233,6 +344,9 @@ base::flat_set<QString> Account::collectGoodNames() const {
 	for (const auto &[key, value] : _draftCursorsMap) {
 		push(value);
 	}
+	for (const auto &[key, value] : _historyCacheMap) {
+		push(value);
+	}
 	for (const auto &value : keys) {
 		push(value);
 	}
@@ -286,6 +400,8 @@ Account::ReadMapResult Account::readMapWith(
 	base::flat_map<PeerId, FileKey> draftsMap;
 	base::flat_map<PeerId, FileKey> draftCursorsMap;
 	base::flat_map<PeerId, bool> draftsNotReadMap;
+	base::flat_map<PeerId, FileKey> historyCacheMap;
+	std::vector<PeerId> historyCacheOrder;
 	quint64 locationsKey = 0, reportSpamStatusesKey = 0, trustedBotsKey = 0;
 	quint64 recentStickersKeyOld = 0;
 	quint64 installedStickersKey = 0, featuredStickersKey = 0, recentStickersKey = 0, favedStickersKey = 0, archivedStickersKey = 0;
@@ -324,6 +440,18 @@ Account::ReadMapResult Account::readMapWith(
 				draftCursorsMap.emplace(peerId, key);
 			}
 		} break;
+		case lskHistoryCache: {
+			quint32 count = 0;
+			map.stream >> count;
+			for (quint32 i = 0; i < count; ++i) {
+				FileKey key;
+				quint64 peerIdSerialized;
+				map.stream >> key >> peerIdSerialized;
+				const auto peerId = DeserializePeerId(peerIdSerialized);
+				historyCacheMap.emplace(peerId, key);
+				historyCacheOrder.push_back(peerId);
+			}
+		} break;
 		case lskLegacyImages:
 		case lskLegacyStickerImages:
 		case lskLegacyAudios: {
@@ -413,6 +541,8 @@ Account::ReadMapResult Account::readMapWith(
 	_draftsMap = draftsMap;
 	_draftCursorsMap = draftCursorsMap;
 	_draftsNotReadMap = draftsNotReadMap;
+	_historyCacheMap = historyCacheMap;
+	_historyCacheOrder = historyCacheOrder;
 
 	_locationsKey = locationsKey;
 	_trustedBotsKey = trustedBotsKey;
@@ -522,6 +652,7 @@ void Account::writeMap() {
 	if (!self.isEmpty()) mapSize += sizeof(quint32) + Serialize::bytearraySize(self);
 	if (!_draftsMap.empty()) mapSize += sizeof(quint32) * 2 + _draftsMap.size() * sizeof(quint64) * 2;
 	if (!_draftCursorsMap.empty()) mapSize += sizeof(quint32) * 2 + _draftCursorsMap.size() * sizeof(quint64) * 2;
+	if (!_historyCacheMap.empty()) mapSize += sizeof(quint32) * 2 + _historyCacheMap.size() * sizeof(quint64) * 2;
 	if (_locationsKey) mapSize += sizeof(quint32) + sizeof(quint64);
 	if (_trustedBotsKey) mapSize += sizeof(quint32) + sizeof(quint64);
 	if (_recentStickersKeyOld) mapSize += sizeof(quint32) + sizeof(quint64);
@@ -556,6 +687,16 @@ void Account::writeMap() {
 			mapData.stream << quint64(value) << SerializePeerId(key);
 		}
 	}
+	if (!_historyCacheMap.empty()) {
+		// Written in the usage order, so that it survives a restart.
+		mapData.stream << quint32(lskHistoryCache) << quint32(_historyCacheMap.size());
+		for (const auto &peerId : _historyCacheOrder) {
+			const auto i = _historyCacheMap.find(peerId);
+			if (i != _historyCacheMap.cend()) {
+				mapData.stream << quint64(i->second) << SerializePeerId(peerId);
+			}
+		}
+	}
 	if (_locationsKey) {
 		mapData.stream << quint32(lskLocations) << quint64(_locationsKey);
 	}
@@ -608,6 +749,13 @@ void Account::reset() {
 	_draftsMap.clear();
 	_draftCursorsMap.clear();
 	_draftsNotReadMap.clear();
+	_historyCacheMap.clear();
+	_historyCacheOrder.clear();
+	_historyCacheWrites.clear();
+	_historyCacheDeleted.clear();
+	_historyCacheDeletedDirty.clear();
+	_historyCacheWriting.clear();
+	_writeHistoryCacheTimer.cancel();
 	_locationsKey = _trustedBotsKey = 0;
 	_recentStickersKeyOld = 0;
 	_installedStickersKey = 0;
@@ -1537,6 +1685,208 @@ bool Account::hasDraft(PeerId peer) {
 	return _draftsMap.contains(peer);
 }
 
+void Account::writeHistoryCache(
+		not_null<History*> history,
+		const MTPmessages_Messages &slice) {
+	const auto peerId = history->peer->id;
+	if (slice.type() == mtpc_messages_messagesNotModified) {
+		return;
+	}
+	_historyCacheWrites[peerId] = slice;
+	touchHistoryCache(peerId);
+	_writeHistoryCacheTimer.callOnce(kDelayedWriteTimeout);
+}
+
+std::optional<MTPmessages_Messages> Account::readHistoryCache(
+		not_null<History*> history) {
+	const auto peerId = history->peer->id;
+	const auto i = _historyCacheMap.find(peerId);
+	const auto w = _historyCacheWrites.find(peerId);
+	if (i == _historyCacheMap.cend() && w == _historyCacheWrites.cend()) {
+		return std::nullopt;
+	}
+	touchHistoryCache(peerId);
+
+	auto result = (w != _historyCacheWrites.cend())
+		? std::make_optional(w->second)
+		: ReadHistoryCacheFile(peerId, i->second, _basePath, _localKey);
+	if (!result) {
+		clearHistoryCache(history);
+		return std::nullopt;
+	}
+
+	// Deleted ids are applied to the file on the next write.
+	const auto j = _historyCacheDeleted.find(peerId);
+	return (j != end(_historyCacheDeleted))
+		? FilterHistoryCache(*result, j->second)
+		: *result;
+}
+
+void Account::clearHistoryCache(not_null<History*> history) {
+	const auto peerId = history->peer->id;
+	_historyCacheWrites.remove(peerId);
+	_historyCacheDeleted.remove(peerId);
+	_historyCacheDeletedDirty.remove(peerId);
+	_historyCacheOrder.erase(
+		ranges::remove(_historyCacheOrder, peerId),
+		end(_historyCacheOrder));
+	const auto i = _historyCacheMap.find(peerId);
+	if (i != _historyCacheMap.cend()) {
+		ClearKey(i->second, _basePath);
+		_historyCacheMap.erase(i);
+		writeMapDelayed();
+	}
+}
+
+void Account::historyCacheMessagesDeleted(
+		PeerId peerId,
+		const QVector<MTPint> &ids) {
+	const auto add = [&](PeerId to) {
+		auto &deleted = _historyCacheDeleted[to];
+		for (const auto &id : ids) {
+			deleted.emplace(id.v);
+		}
+	};
+	if (!peerId) {
+		// Ids of not loaded non-channel messages may be in any of the
+		// non-channel caches. Don't rewrite them all because of that,
+		// the ids are applied when the cache is read or written anyway.
+		for (const auto &[id, key] : _historyCacheMap) {
+			if (!peerIsChannel(id)) {
+				add(id);
+			}
+		}
+		for (const auto &[id, slice] : _historyCacheWrites) {
+			if (!peerIsChannel(id)) {
+				add(id);
+			}
+		}
+		return;
+	} else if (!_historyCacheMap.contains(peerId)
+		&& !_historyCacheWrites.contains(peerId)) {
+		return;
+	}
+	add(peerId);
+	_historyCacheDeletedDirty.emplace(peerId);
+	_writeHistoryCacheTimer.callOnce(kDelayedWriteTimeout);
+}
+
+void Account::touchHistoryCache(PeerId peerId) {
+	const auto i = ranges::find(_historyCacheOrder, peerId);
+	if (i == end(_historyCacheOrder)) {
+		_historyCacheOrder.push_back(peerId);
+	} else {
+		std::rotate(i, i + 1, end(_historyCacheOrder));
+	}
+}
+
+void Account::writeHistoryCaches() {
+	auto peers = base::flat_set<PeerId>();
+	for (const auto &[peerId, slice] : _historyCacheWrites) {
+		peers.emplace(peerId);
+	}
+	for (const auto peerId : base::take(_historyCacheDeletedDirty)) {
+		peers.emplace(peerId);
+	}
+	for (const auto peerId : peers) {
+		auto slice = std::optional<MTPmessages_Messages>();
+		if (const auto i = _historyCacheWrites.find(peerId)
+			; i != end(_historyCacheWrites)) {
+			slice = std::move(i->second);
+			_historyCacheWrites.erase(i);
+		} else if (_historyCacheWriting.contains(peerId)) {
+			// Apply deletions after the file is written, not to a stale one.
+			_historyCacheDeletedDirty.emplace(peerId);
+			_writeHistoryCacheTimer.callOnce(kDelayedWriteTimeout);
+			continue;
+		}
+		auto deleted = base::flat_set<MsgId>();
+		if (const auto i = _historyCacheDeleted.find(peerId)
+			; i != end(_historyCacheDeleted)) {
+			deleted = std::move(i->second);
+			_historyCacheDeleted.erase(i);
+		}
+
+		auto i = _historyCacheMap.find(peerId);
+		if (i == _historyCacheMap.cend()) {
+			if (!slice) {
+				continue;
+			}
+			while (_historyCacheMap.size() >= kMaxHistoryCacheCount
+				&& !_historyCacheOrder.empty()) {
+				const auto j = _historyCacheMap.find(
+					_historyCacheOrder.front());
+				if (j != _historyCacheMap.cend()) {
+					ClearKey(j->second, _basePath);
+					_historyCacheDeleted.remove(j->first);
+					_historyCacheMap.erase(j);
+				}
+				_historyCacheOrder.erase(begin(_historyCacheOrder));
+			}
+			i = _historyCacheMap.emplace(peerId, GenerateKey(_basePath)).first;
+			if (!ranges::contains(_historyCacheOrder, peerId)) {
+				_historyCacheOrder.push_back(peerId);
+			}
+			writeMapQueued();
+		}
+
+		const auto key = i->second;
+		const auto generation = ++_historyCacheGenerations[peerId];
+		_historyCacheWriting.emplace(peerId);
+		crl::async([=,
+				owner = _owner,
+				basePath = _basePath,
+				localKey = _localKey,
+				slice = std::move(slice),
+				deleted = std::move(deleted)] {
+			const auto source = slice
+				? slice
+				: ReadHistoryCacheFile(peerId, key, basePath, localKey);
+			const auto encrypted = source
+				? PrepareHistoryCache(
+					peerId,
+					FilterHistoryCache(*source, deleted),
+					localKey)
+				: QByteArray();
+			auto prepared = std::optional<WriteEntry>();
+			if (!encrypted.isEmpty()) {
+				FileWriteDescriptor file(key, basePath);
+				file.writeData(encrypted);
+				prepared = file.prepare();
+			}
+			crl::on_main(owner, [=, prepared = std::move(prepared)] {
+				historyCacheWritten(peerId, key, generation, prepared);
+			});
+		});
+	}
+}
+
+void Account::historyCacheWritten(
+		PeerId peerId,
+		FileKey key,
+		int generation,
+		std::optional<WriteEntry> prepared) {
+	const auto g = _historyCacheGenerations.find(peerId);
+	if (g == end(_historyCacheGenerations) || g->second != generation) {
+		return;
+	}
+	_historyCacheWriting.remove(peerId);
+
+	const auto i = _historyCacheMap.find(peerId);
+	if (i == _historyCacheMap.cend() || i->second != key) {
+		return;
+	} else if (!prepared) {
+		ClearKey(i->second, _basePath);
+		_historyCacheMap.erase(i);
+		_historyCacheOrder.erase(
+			ranges::remove(_historyCacheOrder, peerId),
+			end(_historyCacheOrder));
+		writeMapDelayed();
+		return;
+	}
+	WriteFile(std::move(*prepared));
+}
+
 void Account::writeFileLocation(MediaKey location, const Core::FileLocation &local) {
 	if (local.fname.isEmpty()) {
 		return;
@@ -42,6 +42,7 @@ namespace Storage {
 namespace details {
 struct ReadSettingsContext;
 struct FileReadDescriptor;
+struct WriteEntry;
 } // namespace details
 
 class EncryptionKey;
@@ -97,6 +98,18 @@ public:
 	[[nodiscard]] bool hasDraftCursors(PeerId peerId);
 	[[nodiscard]] bool hasDraft(PeerId peerId);
 
+	void writeHistoryCache(
+		not_null<History*> history,
+		const MTPmessages_Messages &slice);
+	[[nodiscard]] std::optional<MTPmessages_Messages> readHistoryCache(
+		not_null<History*> history);
+	void clearHistoryCache(not_null<History*> history);
+
+	// Pass an empty peerId for non-channel messages that are not loaded.
+	void historyCacheMessagesDeleted(
+		PeerId peerId,
+		const QVector<MTPint> &ids);
+
 	void writeFileLocation(
 		MediaKey location,
 		const Core::FileLocation &local);
@@ -248,6 +261,14 @@ private:
 		Fn<RecentHashtagPack()> getPack,
 		const QString &text);
 
+	void touchHistoryCache(PeerId peerId);
+	void writeHistoryCaches();
+	void historyCacheWritten(
+		PeerId peerId,
+		FileKey key,
+		int generation,
+		std::optional<details::WriteEntry> prepared);
+
 	const not_null<Main::Account*> _owner;
 	const QString _dataName;
 	const FileKey _dataNameKey = 0;
@@ -260,6 +281,13 @@ private:
 	base::flat_map<PeerId, FileKey> _draftsMap;
 	base::flat_map<PeerId, FileKey> _draftCursorsMap;
 	base::flat_map<PeerId, bool> _draftsNotReadMap;
+	base::flat_map<PeerId, FileKey> _historyCacheMap;
+	std::vector<PeerId> _historyCacheOrder; // Least recently used first.
+	base::flat_map<PeerId, MTPmessages_Messages> _historyCacheWrites;
+	base::flat_map<PeerId, base::flat_set<MsgId>> _historyCacheDeleted;
+	base::flat_set<PeerId> _historyCacheDeletedDirty;
+	base::flat_map<PeerId, int> _historyCacheGenerations;
+	base::flat_set<PeerId> _historyCacheWriting;
 	base::flat_map<
 		not_null<History*>,
 		base::flat_map<Data::DraftKey, MessageDraftSource>> _draftSources;
@@ -306,6 +334,7 @@ private:
 
 	base::Timer _writeMapTimer;
 	base::Timer _writeLocationsTimer;
+	base::Timer _writeHistoryCacheTimer;
 	bool _mapChanged = false;
 	bool _locationsChanged = false;
 
@@ -15,17 +15,29 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include "ui/color_contrast.h"
 #include "ui/style/style_core_palette.h"
 #include "ui/style/style_palette_colorizer.h"
+#include "core/core_parallel.h"
 
 #include <crl/crl_async.h>
+#include <QtCore/QMutex>
+#include <QtCore/QThread>
 #include <QtGui/QGuiApplication>
 
 namespace Ui {
+
+struct PatternScaledCache {
+	QMutex mutex;
+	qint64 key = 0;
+	int size = 0;
+	QImage scaled;
+};
+
 namespace {
 
 constexpr auto kCacheBackgroundTimeout = 1 * crl::time(1000);
 constexpr auto kCacheBackgroundFastTimeout = crl::time(200);
 constexpr auto kBackgroundFadeDuration = crl::time(200);
 constexpr auto kMinimumTiledSize = 512;
+constexpr auto kMinBackgroundBandHeight = 256;
 constexpr auto kMaxSize = 2960;
 constexpr auto kMaxContrastValue = 21.;
 constexpr auto kMinAcceptableContrast = 1.14;// 4.5;
@@ -53,8 +65,143 @@ constexpr auto kMinAcceptableContrast = 1.14;// 4.5;
 	return (doubled % 2) ? 0.5 : 1.;
 }
 
+[[nodiscard]] QImage PatternScaledCached(
+		const QImage &prepared,
+		int size,
+		PatternScaledCache *cache) {
+	const auto scale = [&] {
+		return prepared.scaled(
+			size,
+			size,
+			Qt::KeepAspectRatio,
+			Qt::SmoothTransformation);
+	};
+	if (!cache) {
+		return scale();
+	}
+
+	// Keep the last scaled pattern, resizes that keep the chat height
+	// won't rescale it again.
+	QMutexLocker lock(&cache->mutex);
+	if (cache->key != prepared.cacheKey() || cache->size != size) {
+		cache->key = prepared.cacheKey();
+		cache->size = size;
+		cache->scaled = scale();
+	}
+	return cache->scaled;
+}
+
+// Themes usually have the same pattern for the same area, so all of them
+// share one scaled pattern instead of keeping a full-size copy each.
+[[nodiscard]] std::shared_ptr<PatternScaledCache> SharedPatternScaledCache() {
+	static QMutex Mutex;
+	static std::weak_ptr<PatternScaledCache> Weak;
+
+	QMutexLocker lock(&Mutex);
+	auto result = Weak.lock();
+	if (!result) {
+		result = std::make_shared<PatternScaledCache>();
+		Weak = result;
+	}
+	return result;
+}
+
+void PaintBackgroundBand(
+		const CacheBackgroundRequest &request,
+		const QImage &gradient,
+		const QImage &tiled,
+		const QImage &result,
+		uchar *bits,
+		int fromRow,
+		int tillRow) {
+	const auto ratio = style::DevicePixelRatio();
+	auto band = QImage(
+		bits + fromRow * result.bytesPerLine(),
+		result.width(),
+		tillRow - fromRow,
+		result.bytesPerLine(),
+		result.format());
+	band.setDevicePixelRatio(ratio);
+
+	const auto top = fromRow / float64(ratio);
+	const auto bottom = tillRow / float64(ratio);
+	QPainter p(&band);
+	p.translate(0., -top);
+	if (!gradient.isNull()) {
+		p.setRenderHint(QPainter::SmoothPixmapTransform);
+		p.setCompositionMode(QPainter::CompositionMode_Source);
+		p.drawImage(QRect(QPoint(), request.area), gradient);
+	}
+	if (tiled.isNull()) {
+		return;
+	} else if (!gradient.isNull()) {
+		if (request.background.patternOpacity >= 0.) {
+			p.setCompositionMode(QPainter::CompositionMode_SoftLight);
+			p.setOpacity(request.background.patternOpacity);
+		} else {
+			p.setCompositionMode(QPainter::CompositionMode_DestinationIn);
+		}
+	} else {
+		p.setCompositionMode(QPainter::CompositionMode_SourceOver);
+	}
+	const auto w = tiled.width() / float(ratio);
+	const auto h = tiled.height() / float(ratio);
+	const auto cx = int(std::ceil(request.area.width() / w));
+	const auto cy = int(std::ceil(request.area.height() / h));
+	const auto rows = cy;
+	const auto cols = request.background.isPattern
+		? (((cx / 2) * 2) + 1)
+		: cx;
+	const auto xshift = request.background.isPattern
+		? (request.area.width() * ratio - cols * tiled.width()) / 2
+		: 0;
+	const auto useshift = xshift / float(ratio);
+	for (auto y = 0; y != rows; ++y) {
+		if ((y + 1) * h <= top) {
+			continue;
+		} else if (y * h >= bottom) {
+			break;
+		}
+		for (auto x = 0; x != cols; ++x) {
+			p.drawImage(QPointF(useshift + x * w, y * h), tiled);
+		}
+	}
+	if (!gradient.isNull()
+		&& request.background.patternOpacity < 0.
+		&& request.background.patternOpacity > -1.) {
+		p.setCompositionMode(QPainter::CompositionMode_SourceOver);
+		p.setOpacity(1. + request.background.patternOpacity);
+		p.fillRect(QRect(QPoint(), request.area), Qt::black);
+	}
+}
+
+void PaintBackgroundBands(
+		const CacheBackgroundRequest &request,
+		const QImage &gradient,
+		const QImage &tiled,
+		QImage &result) {
+	const auto height = result.height();
+	const auto count = std::clamp(
+		height / kMinBackgroundBandHeight,
+		1,
+		QThread::idealThreadCount());
+	const auto bits = result.bits();
+	const auto paint = [&](int index) {
+		PaintBackgroundBand(
+			request,
+			gradient,
+			tiled,
+			result,
+			bits,
+			height * index / count,
+			height * (index + 1) / count);
+	};
+	Core::InvokeParallel(count, paint);
+}
+
 [[nodiscard]] CacheBackgroundResult CacheBackgroundByRequest(
-		const CacheBackgroundRequest &request) {
+		const CacheBackgroundRequest &request,
+		PatternScaledCache *patternCache) {
 	Expects(!request.area.isEmpty());
 
 	const auto ratio = style::DevicePixelRatio();
@@ -70,57 +217,22 @@ constexpr auto kMinAcceptableContrast = 1.14;// 4.5;
 	if (request.background.isPattern
 		|| request.background.tile
 		|| request.background.prepared.isNull()) {
-		auto result = gradient.isNull()
-			? QImage(
-				request.area * ratio,
-				QImage::Format_ARGB32_Premultiplied)
-			: gradient.scaled(
-				request.area * ratio,
-				Qt::IgnoreAspectRatio,
-				Qt::SmoothTransformation);
+		auto result = QImage(
+			request.area * ratio,
+			((gradient.isNull() || gradient.hasAlphaChannel())
+				? QImage::Format_ARGB32_Premultiplied
+				: QImage::Format_RGB32));
 		result.setDevicePixelRatio(ratio);
-		if (!request.background.prepared.isNull()) {
-			QPainter p(&result);
-			if (!gradient.isNull()) {
-				if (request.background.patternOpacity >= 0.) {
-					p.setCompositionMode(QPainter::CompositionMode_SoftLight);
-					p.setOpacity(request.background.patternOpacity);
-				} else {
-					p.setCompositionMode(
-						QPainter::CompositionMode_DestinationIn);
-				}
-			}
-			const auto tiled = request.background.isPattern
-				? request.background.prepared.scaled(
-					request.area.height() * ratio,
-					request.area.height() * ratio,
-					Qt::KeepAspectRatio,
-					Qt::SmoothTransformation)
-				: request.background.preparedForTiled;
-			const auto w = tiled.width() / float(ratio);
-			const auto h = tiled.height() / float(ratio);
-			const auto cx = int(std::ceil(request.area.width() / w));
-			const auto cy = int(std::ceil(request.area.height() / h));
-			const auto rows = cy;
-			const auto cols = request.background.isPattern
-				? (((cx / 2) * 2) + 1)
-				: cx;
-			const auto xshift = request.background.isPattern
-				? (request.area.width() * ratio - cols * tiled.width()) / 2
-				: 0;
-			const auto useshift = xshift / float(ratio);
-			for (auto y = 0; y != rows; ++y) {
-				for (auto x = 0; x != cols; ++x) {
-					p.drawImage(QPointF(useshift + x * w, y * h), tiled);
-				}
-			}
-			if (!gradient.isNull()
-				&& request.background.patternOpacity < 0.
-				&& request.background.patternOpacity > -1.) {
-				p.setCompositionMode(QPainter::CompositionMode_SourceOver);
-				p.setOpacity(1. + request.background.patternOpacity);
-				p.fillRect(QRect(QPoint(), request.area), Qt::black);
-			}
+		const auto tiled = request.background.prepared.isNull()
+			? QImage()
+			: request.background.isPattern
+			? PatternScaledCached(
+				request.background.prepared,
+				request.area.height() * ratio,
+				patternCache)
+			: request.background.preparedForTiled;
+		if (!gradient.isNull() || !tiled.isNull()) {
+			PaintBackgroundBands(request, gradient, tiled, result);
 		}
 		return {
 			.image = std::move(result).convertToFormat(
@@ -190,8 +302,9 @@ bool operator!=(
 }
 
 CacheBackgroundResult CacheBackground(
-		const CacheBackgroundRequest &request) {
-	return CacheBackgroundByRequest(request);
+		const CacheBackgroundRequest &request,
+		PatternScaledCache *patternCache) {
+	return CacheBackgroundByRequest(request, patternCache);
 }
 
 CachedBackground::CachedBackground(CacheBackgroundResult &&result)
@@ -202,13 +315,15 @@ CachedBackground::CachedBackground(CacheBackgroundResult &&result)
 , waitingForNegativePattern(result.waitingForNegativePattern) {
 }
 
-ChatTheme::ChatTheme() {
+ChatTheme::ChatTheme()
+: _patternScaledCache(SharedPatternScaledCache()) {
 }
 
 // Runs from background thread.
 ChatTheme::ChatTheme(ChatThemeDescriptor &&descriptor)
 : _key(descriptor.key)
-, _palette(std::make_unique<style::palette>()) {
+, _palette(std::make_unique<style::palette>())
+, _patternScaledCache(SharedPatternScaledCache()) {
 	descriptor.preparePalette(*_palette);
 	setBackground(PrepareBackgroundImage(descriptor.backgroundData));
 	setBubblesBackground(PrepareBubblesBackground(descriptor.bubblesData));
@@ -504,7 +619,9 @@ const BackgroundState &ChatTheme::backgroundState(QSize area) {
 		// We don't support direct painting of patterned gradients.
 		// So we need to sync-generate cache image here.
 		_cacheBackgroundArea = area;
-		setCachedBackground(CacheBackground(cacheBackgroundRequest(area)));
+		setCachedBackground(CacheBackground(
+			cacheBackgroundRequest(area),
+			_patternScaledCache.get()));
 		_cacheBackgroundTimer->cancel();
 	} else if (_backgroundState.now.area != area) {
 		if (_cacheBackgroundArea != area
@@ -602,11 +719,13 @@ void ChatTheme::cacheBackgroundAsync(
 		Fn<void(CacheBackgroundResult&&)> done) {
 	_backgroundCachingRequest = request;
 	const auto weak = base::make_weak(this);
+	const auto cache = _patternScaledCache;
 	crl::async([=] {
 		if (!weak) {
 			return;
 		}
-		crl::on_main(weak, [=, result = CacheBackground(request)]() mutable {
+		auto result = CacheBackground(request, cache.get());
+		crl::on_main(weak, [=, result = std::move(result)]() mutable {
 			if (done) {
 				done(std::move(result));
 			} else if (const auto request = cacheBackgroundRequest(
@@ -90,8 +90,12 @@ struct CacheBackgroundResult {
 	bool waitingForNegativePattern = false;
 };
 
+// Keeps the last scaled pattern, may be used from any thread.
+struct PatternScaledCache;
+
 [[nodiscard]] CacheBackgroundResult CacheBackground(
-	const CacheBackgroundRequest &request);
+	const CacheBackgroundRequest &request,
+	PatternScaledCache *patternCache = nullptr);
 
 struct CachedBackground {
 	CachedBackground() = default;
@@ -213,6 +217,9 @@ private:
 	std::optional<base::Timer> _cacheBubblesTimer;
 	std::unique_ptr<BubblePattern> _bubblesBackgroundPattern;
 
+	// Shared with other themes and with the caching tasks.
+	std::shared_ptr<PatternScaledCache> _patternScaledCache;
+
 	rpl::event_stream<> _repaintBackgroundRequests;
 
 	rpl::lifetime _lifetime;
@@ -13,8 +13,12 @@ nice_target_sources(td_mtproto ${src_loc}
 PRIVATE
     mtproto/details/mtproto_abstract_socket.cpp
     mtproto/details/mtproto_abstract_socket.h
+    mtproto/details/mtproto_aes_ige.cpp
+    mtproto/details/mtproto_aes_ige.h
     mtproto/details/mtproto_bound_key_creator.cpp
     mtproto/details/mtproto_bound_key_creator.h
+    mtproto/details/mtproto_buffer_pool.cpp
+    mtproto/details/mtproto_buffer_pool.h
     mtproto/details/mtproto_dc_key_binder.cpp
     mtproto/details/mtproto_dc_key_binder.h
     mtproto/details/mtproto_dc_key_creator.cpp
@@ -25,6 +29,7 @@ PRIVATE
     mtproto/details/mtproto_domain_resolver.h
     mtproto/details/mtproto_dump_to_text.cpp
     mtproto/details/mtproto_dump_to_text.h
+    mtproto/details/mtproto_handoff_queue.h
     mtproto/details/mtproto_received_ids_manager.cpp
     mtproto/details/mtproto_received_ids_manager.h
     mtproto/details/mtproto_rsa_public_key.cpp
@@ -175,6 +175,8 @@ PRIVATE
     settings/settings_common.cpp
     settings/settings_common.h
 
+    statistics/chart_levels_of_detail.cpp
+    statistics/chart_levels_of_detail.h
     statistics/chart_lines_filter_controller.cpp
     statistics/chart_lines_filter_controller.h
     statistics/chart_rulers_data.cpp